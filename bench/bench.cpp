@@ -0,0 +1,428 @@
+/* glfw-hpp-bench: per-call cost of the C++ layer next to the equivalent raw GLFW calls.
+ * Headless on GLFW 3.4+ through the null platform, older versions need a display (e.g. xvfb-run).
+ * Usage: glfw-hpp-bench [filter], only cases whose "group/name" contains filter are run. */
+#include "GLFW.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+
+namespace {
+
+template<class T>
+inline void do_not_optimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile char sink;
+	sink = *reinterpret_cast<char const volatile*>(&value);
+#endif
+}
+
+char const* filter = nullptr;
+
+/* best ns per operation of several runs, operation is run iterations times per run */
+template<class Operation>
+double measure(size_t iterations, Operation&& operation) {
+	using clock = std::chrono::steady_clock;
+	for (size_t i = 0; i < iterations / 10 + 1; ++i) operation();
+
+	double best = 0.0;
+	for (int run = 0; run < 5; ++run) {
+		auto start = clock::now();
+		for (size_t i = 0; i < iterations; ++i) operation();
+		double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / static_cast<double>(iterations);
+		if (run == 0 || ns < best) best = ns;
+	}
+	return best;
+}
+
+bool selected(char const* group, char const* name) {
+	if (!filter) return true;
+	char id[128];
+	std::snprintf(id, sizeof(id), "%s/%s", group, name);
+	return std::strstr(id, filter) != nullptr;
+}
+
+/* raw is the baseline of its group, later cases report their ratio to it */
+struct group {
+	char const* name;
+	double baseline = 0.0;
+
+	template<class Operation>
+	void run(char const* caseName, size_t iterations, Operation&& operation) {
+		if (!selected(name, caseName)) return;
+		double ns = measure(iterations, std::forward<Operation>(operation));
+		if (baseline == 0.0) {
+			baseline = ns;
+			std::printf("%-10s %-34s %10.2f ns\n", name, caseName, ns);
+		}
+		else std::printf("%-10s %-34s %10.2f ns  %6.2fx\n", name, caseName, ns, ns / baseline);
+	}
+};
+
+/* Callback dispatch: GLFW calls the trampoline through a function pointer, so does the benchmark */
+
+uint64_t dispatched = 0;
+
+void raw_key_callback(GLFWwindow* window, int key, int, int, int) {
+	*static_cast<uint64_t*>(glfwGetWindowUserPointer(window)) += static_cast<uint64_t>(key);
+}
+
+struct counting_handler : glfw::handler<counting_handler> {
+	void on_key(glfw::key_event e) { dispatched += static_cast<uint64_t>(e.key); }
+};
+
+void bench_dispatch(glfw::window& window) {
+	group dispatch{ "dispatch" };
+	GLFWkeyfun volatile trampoline = &raw_key_callback;
+	int key = static_cast<int>(glfw::key::A);
+
+	{
+		//the raw callback needs the user pointer, the wrapper owns it while the window lives
+		void* wrapperBlock = glfwGetWindowUserPointer(window);
+		uint64_t counter = 0;
+		glfwSetWindowUserPointer(window, &counter);
+		dispatch.run("raw C callback", 1'000'000, [&] { trampoline(window, key, 0, GLFW_PRESS, 0); });
+		glfwSetWindowUserPointer(window, wrapperBlock);
+		do_not_optimize(counter);
+	}
+
+	trampoline = &glfw::detail::callbacks::glfw_key_callback;
+	glfw::input::set_key_callback(window, [](glfw::key_event e) { dispatched += static_cast<uint64_t>(e.key); });
+	dispatch.run("wrapper inplace_function", 1'000'000, [&] { trampoline(window, key, 0, GLFW_PRESS, 0); });
+	glfw::input::set_key_callback(window, nullptr);
+
+	{
+		//the dispatch the callback layer used before: window -> std::function map, plus the timestamp read the trampolines do
+		std::unordered_map<GLFWwindow*, std::function<void(glfw::key_event)>> callbacks;
+		callbacks[window] = [](glfw::key_event e) { dispatched += static_cast<uint64_t>(e.key); };
+		GLFWwindow* handle = window;
+		dispatch.run("previous map + std::function", 1'000'000, [&] {
+			auto it = callbacks.find(handle);
+			if (it != callbacks.end()) it->second(glfw::key_event{ glfw::window_ref{ handle }, glfw::key{ key }, 0, glfw::key_action::Press, glfw::modifier_flags{ 0 }, glfwGetTimerValue() });
+		});
+	}
+
+	{
+		counting_handler handler;
+		handler.install(window);
+		GLFWkeyfun installed = glfwSetKeyCallback(window, nullptr);
+		glfwSetKeyCallback(window, installed);
+		trampoline = installed;
+		dispatch.run("wrapper static handler", 1'000'000, [&] { trampoline(window, key, 0, GLFW_PRESS, 0); });
+		counting_handler::uninstall(window);
+	}
+	do_not_optimize(dispatched);
+}
+
+/* Callback storage alone: the same capturing lambda invoked directly, no window lookup or event construction */
+
+void bench_invoke() {
+	group invoke{ "invoke" };
+	uint64_t counter = 0;
+	auto callable = [&counter](glfw::key_event e) { counter += static_cast<uint64_t>(e.key); };
+	glfw::key_event e{ glfw::window_ref{ nullptr }, glfw::key::A, 0, glfw::key_action::Press, glfw::modifier_flags{ 0 } };
+
+	std::function<void(glfw::key_event)> function = callable;
+	glfw::inplace_function<void(glfw::key_event)> inplaceFunction = callable;
+	//keep the compiler from seeing through the stored callable
+	do_not_optimize(&function);
+	do_not_optimize(&inplaceFunction);
+	invoke.run("std::function", 10'000'000, [&] { function(e); });
+	invoke.run("inplace_function", 10'000'000, [&] { inplaceFunction(e); });
+	do_not_optimize(counter);
+}
+
+/* Buffered events: 256 key events through the wrapper's key trampoline, one poll_events, then one pass over the
+ * collected events. Both cases run the same trampoline (lookup, timestamp, record hook) and poll bookkeeping; the variant
+ * case stores each event from a registered key callback into a vector of event variants, the per-callback struct path
+ * buffered mode replaced, the ring case has buffered mode append compact glfw::event records. */
+
+using event_variant = std::variant<glfw::key_event, glfw::char_event, glfw::cursor_event, glfw::cursor_enter_event, glfw::mouse_button_event, glfw::mouse_scroll_event, glfw::drop_event>;
+
+void bench_buffered(glfw::window& window) {
+	group buffered{ "buffered" };
+	constexpr int BATCH = 256;
+	GLFWkeyfun volatile trampoline = &glfw::detail::callbacks::glfw_key_callback;
+	int key = static_cast<int>(glfw::key::A);
+	uint64_t sum = 0;
+
+	{
+		std::vector<event_variant> events;
+		glfw::input::set_key_callback(window, [&events](glfw::key_event e) { events.emplace_back(e); });
+		buffered.run("variant vector via key callback", 20'000, [&] {
+			events.clear();
+			for (int i = 0; i < BATCH; ++i) trampoline(window, key, 0, GLFW_PRESS, 0);
+			glfw::poll_events();
+			for (auto& e : events) if (auto keyEvent = std::get_if<glfw::key_event>(&e)) sum += static_cast<uint64_t>(keyEvent->key);
+		});
+		glfw::input::set_key_callback(window, nullptr);
+	}
+
+	glfw::buffered_events::enable(window);
+	buffered.run("glfw::event ring via buffered mode", 20'000, [&] {
+		for (int i = 0; i < BATCH; ++i) trampoline(window, key, 0, GLFW_PRESS, 0);
+		for (auto& e : glfw::poll_events()) if (e.type == glfw::event_type::Key) sum += static_cast<uint64_t>(e.key.key);
+	});
+	glfw::buffered_events::disable(window);
+	glfw::poll_events();
+	do_not_optimize(sum);
+}
+
+/* Main thread commands: 256 posts, then one poll running them.
+ * Single producer and the null platform's glfwPostEmptyEvent is free, so neither contention nor wakeups are in the numbers.
+ * The contended cases post from 4 producer threads at once while the main thread drains until all commands ran. */
+
+constexpr int PRODUCERS = 4;
+constexpr int PRODUCER_BATCH = 128;
+
+/* producer threads posting PRODUCER_BATCH commands each whenever the main thread starts a round */
+class producer_pool {
+public:
+	template<class Post>
+	explicit producer_pool(Post post) {
+		for (int i = 0; i < PRODUCERS; ++i) {
+			m_threads.emplace_back([this, post] {
+				uint64_t seen = 0;
+				for (;;) {
+					uint64_t round;
+					while ((round = m_round.load(std::memory_order_acquire)) == seen) std::this_thread::yield();
+					if (round == STOP) return;
+					seen = round;
+					for (int item = 0; item < PRODUCER_BATCH; ++item) post();
+				}
+			});
+		}
+	}
+	~producer_pool() {
+		m_round.store(STOP, std::memory_order_release);
+		for (auto& thread : m_threads) thread.join();
+	}
+
+	void start_round() { m_round.fetch_add(1, std::memory_order_release); }
+
+private:
+	static constexpr uint64_t STOP = UINT64_MAX;
+	std::atomic<uint64_t> m_round{ 0 };
+	std::vector<std::thread> m_threads;
+};
+
+void bench_commands() {
+	group commands{ "commands" };
+	constexpr int BATCH = 256;
+	uint64_t counter = 0;
+
+	{
+		//mutex-protected queue waking the event loop for every item
+		std::mutex mutex;
+		std::deque<std::function<void()>> queue;
+		commands.run("mutex queue + wakeup per post", 5'000, [&] {
+			for (int i = 0; i < BATCH; ++i) {
+				{
+					std::lock_guard lock{ mutex };
+					queue.emplace_back([&counter] { ++counter; });
+				}
+				glfw::post_empty_event();
+			}
+			glfwPollEvents();
+			std::lock_guard lock{ mutex };
+			while (!queue.empty()) {
+				queue.front()();
+				queue.pop_front();
+			}
+		});
+	}
+
+	commands.run("main_thread::post", 5'000, [&] {
+		for (int i = 0; i < BATCH; ++i) glfw::main_thread::post([&counter] { ++counter; });
+		glfw::poll_events();
+	});
+	do_not_optimize(counter);
+
+	group contended{ "commands" };
+	constexpr uint64_t ROUND = PRODUCERS * PRODUCER_BATCH;
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> queue;
+		uint64_t executed = 0;
+		producer_pool producers{ [&] {
+			{
+				std::lock_guard lock{ mutex };
+				queue.emplace_back([&executed] { ++executed; });
+			}
+			glfw::post_empty_event();
+		} };
+		contended.run("mutex queue, 4 producers", 100, [&] {
+			uint64_t target = executed + ROUND;
+			producers.start_round();
+			while (executed != target) {
+				glfwPollEvents();
+				std::lock_guard lock{ mutex };
+				while (!queue.empty()) {
+					queue.front()();
+					queue.pop_front();
+				}
+			}
+		});
+	}
+	{
+		uint64_t executed = 0;
+		producer_pool producers{ [&] {
+			while (!glfw::main_thread::post([&executed] { ++executed; })) std::this_thread::yield();
+		} };
+		contended.run("main_thread::post, 4 producers", 100, [&] {
+			uint64_t target = executed + ROUND;
+			producers.start_round();
+			while (executed != target) glfw::poll_events();
+		});
+	}
+}
+
+/* Window attribute getters */
+
+void bench_getters(glfw::window& window) {
+	{
+		group size{ "getters" };
+		size.run("raw glfwGetWindowSize", 1'000'000, [&] {
+			int width, height;
+			glfwGetWindowSize(window, &width, &height);
+			do_not_optimize(width + height);
+		});
+		size.run("window::size", 1'000'000, [&] { do_not_optimize(window.size()); });
+		glfw::cached_geometry::enable(window);
+		size.run("window::size cached", 1'000'000, [&] { do_not_optimize(window.size()); });
+		glfw::cached_geometry::disable(window);
+	}
+	{
+		group framebuffer{ "getters" };
+		framebuffer.run("raw glfwGetFramebufferSize", 1'000'000, [&] {
+			int width, height;
+			glfwGetFramebufferSize(window, &width, &height);
+			do_not_optimize(width + height);
+		});
+		framebuffer.run("window::get_framebuffer_size", 1'000'000, [&] { do_not_optimize(window.get_framebuffer_size()); });
+	}
+	{
+		group attribute{ "getters" };
+		attribute.run("raw glfwGetWindowAttrib", 1'000'000, [&] { do_not_optimize(glfwGetWindowAttrib(window, GLFW_MAXIMIZED)); });
+		attribute.run("window::is_maximized", 1'000'000, [&] { do_not_optimize(window.is_maximized()); });
+		glfw::cached_state::enable(window);
+		attribute.run("window::is_maximized cached", 1'000'000, [&] { do_not_optimize(window.is_maximized()); });
+		glfw::cached_state::disable(window);
+	}
+}
+
+/* Monitors */
+
+void bench_monitors() {
+	{
+		group monitors{ "monitor" };
+		monitors.run("raw glfwGetMonitors", 1'000'000, [] {
+			int count = 0;
+			do_not_optimize(glfwGetMonitors(&count));
+			do_not_optimize(count);
+		});
+		monitors.run("monitor::get_monitors", 1'000'000, [] { do_not_optimize(glfw::monitor::get_monitors().size()); });
+	}
+
+	auto primary = glfw::monitor::get_primary_monitor();
+	if (!static_cast<GLFWmonitor*>(primary)) return;
+	group modes{ "monitor" };
+	modes.run("raw glfwGetVideoModes", 1'000'000, [&] {
+		int count = 0;
+		do_not_optimize(glfwGetVideoModes(primary, &count));
+		do_not_optimize(count);
+	});
+	modes.run("monitor::get_video_modes", 1'000'000, [&] { do_not_optimize(primary.get_video_modes().size()); });
+
+	group current{ "monitor" };
+	current.run("raw glfwGetVideoMode", 1'000'000, [&] { do_not_optimize(glfwGetVideoMode(primary)->width); });
+	current.run("monitor::get_current_video_mode", 1'000'000, [&] { do_not_optimize(primary.get_current_video_mode()); });
+	glfw::monitor_registry::enable();
+	current.run("get_current_video_mode registry", 1'000'000, [&] { do_not_optimize(primary.get_current_video_mode()); });
+	current.run("monitor_registry::monitors", 1'000'000, [] { do_not_optimize(glfw::monitor_registry::monitors().size()); });
+	glfw::monitor_registry::disable();
+}
+
+/* Window creation with hints, includes destroying the window */
+
+void bench_builder() {
+	using namespace glfw::attributes;
+	group builder{ "builder" };
+	builder.run("raw glfwWindowHint + create", 500, [] {
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_SAMPLES, 4);
+		GLFWwindow* window = glfwCreateWindow(64, 64, "bench", nullptr, nullptr);
+		glfwDefaultWindowHints();
+		glfwDestroyWindow(window);
+	});
+	builder.run("window_builder::create", 500, [] {
+		glfw::window_builder windowBuilder{ client_api_hint{ client_api_type::None }, hint{ hint_type::Visible, false }, hint{ hint_type::Resizable, false }, value_hint{ value_hint_type::Samples, 4 } };
+		auto window = windowBuilder.create(glfw::window_size{ 64, 64 }, "bench");
+		do_not_optimize(static_cast<GLFWwindow*>(window));
+	});
+	builder.run("static_window_builder::create", 500, [] {
+		glfw::static_window_builder<fixed_client_api_hint<client_api_type::None>, fixed_hint<hint_type::Visible, false>, fixed_hint<hint_type::Resizable, false>, fixed_value_hint<value_hint_type::Samples, 4>> windowBuilder;
+		auto window = windowBuilder.create(glfw::window_size{ 64, 64 }, "bench");
+		do_not_optimize(static_cast<GLFWwindow*>(window));
+	});
+}
+
+/* Gamepads */
+
+void bench_gamepads() {
+	{
+		group single{ "gamepad" };
+		single.run("raw glfwGetGamepadState", 1'000'000, [] {
+			GLFWgamepadstate state;
+			do_not_optimize(glfwGetGamepadState(GLFW_JOYSTICK_1, &state));
+		});
+		single.run("input::current_gamepad_state", 1'000'000, [] { do_not_optimize(glfw::input::current_gamepad_state(glfw::joystick_id::ID1)); });
+	}
+	group all{ "gamepad" };
+	all.run("raw glfwGetGamepadState x16", 100'000, [] {
+		GLFWgamepadstate state;
+		for (int pad = GLFW_JOYSTICK_1; pad <= GLFW_JOYSTICK_LAST; ++pad) do_not_optimize(glfwGetGamepadState(pad, &state));
+	});
+	all.run("input::poll_all_gamepads", 100'000, [] { do_not_optimize(glfw::input::poll_all_gamepads().dirty); });
+}
+
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1) filter = argv[1];
+
+#ifdef GLFW_PLATFORM
+	glfw::init(glfw::platform_type::Null);
+#else
+	glfw::init();
+#endif
+
+	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfw::window window{ glfw::window_size{ 640, 480 }, "glfw-hpp-bench" };
+	glfwDefaultWindowHints();
+	if (!static_cast<GLFWwindow*>(window)) {
+		std::fprintf(stderr, "glfw-hpp-bench: failed to create a window\n");
+		return 1;
+	}
+
+	bench_dispatch(window);
+	bench_invoke();
+	bench_buffered(window);
+	bench_commands();
+	bench_getters(window);
+	bench_monitors();
+	bench_builder();
+	bench_gamepads();
+	return 0;
+}
@@ -7,9 +7,76 @@
 #include <variant>
 #include <optional>
 #include <functional>
+#include <memory>
+#include <utility>
 #include <unordered_map>
+#include <string>
 #include <cstdint>
 #include <array>
+#include <iterator>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <initializer_list>
+
+#ifdef GLFWHPP_RECORD_REPLAY
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#endif
+
+/* External reactor integration (glfw::reactor): GLFWHPP_REACTOR for the wakeup eventfd, GLFWHPP_REACTOR_X11 / _WAYLAND
+ * additionally expose the display connection and require linking libX11 / libwayland-client */
+#if defined(GLFWHPP_REACTOR_X11) || defined(GLFWHPP_REACTOR_WAYLAND)
+#ifndef GLFWHPP_REACTOR
+#define GLFWHPP_REACTOR
+#endif
+#endif
+
+#ifdef GLFWHPP_REACTOR
+#ifndef __linux__
+#error "GLFWHPP_REACTOR needs eventfd, which is Linux only"
+#endif
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+
+/* the native prototypes, declared here so neither Xlib nor Wayland headers are needed; they match glfw3native.h */
+extern "C" {
+#ifdef GLFWHPP_REACTOR_X11
+struct _XDisplay;
+struct _XDisplay* glfwGetX11Display(void);
+int XConnectionNumber(struct _XDisplay*);
+int XFlush(struct _XDisplay*);
+int XEventsQueued(struct _XDisplay*, int mode);
+#endif
+#ifdef GLFWHPP_REACTOR_WAYLAND
+struct wl_display;
+struct wl_display* glfwGetWaylandDisplay(void);
+int wl_display_get_fd(struct wl_display*);
+int wl_display_flush(struct wl_display*);
+int wl_display_prepare_read(struct wl_display*);
+int wl_display_read_events(struct wl_display*);
+void wl_display_cancel_read(struct wl_display*);
+#endif
+}
+#endif
+
+/* C++20 coroutine awaitables (glfw::async), available when the compiler supports coroutines */
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>) && !defined(GLFWHPP_NO_COROUTINES)
+#include <coroutine>
+#define GLFWHPP_COROUTINES
+#endif
 //TODOS:
 //return value sfinae -> static_assert
 //string handling to properly accept c_str instead of string_view (unsafe!)
@@ -28,22 +95,31 @@ inline constexpr int TRUE = GLFW_TRUE;
 inline void set_swap_interval(int swapInterval) {
 	glfwSwapInterval(swapInterval);
 }
-/* Events */
-
-inline void poll_events() {
-	glfwPollEvents();
-}
+/* Events - poll_events / wait_events are defined after the event queue */
 
-inline void wait_events() {
-	glfwWaitEvents();
-}
-
-inline void wait_events(double timeout) {
-	glfwWaitEventsTimeout(timeout);
+#ifdef GLFWHPP_REACTOR
+namespace detail {
+/* eventfd of reactor::wake_fd, closed at exit */
+struct wake_fd_holder {
+	std::atomic<int> fd{ -1 };
+	~wake_fd_holder() {
+		int current = fd.exchange(-1);
+		if (current >= 0) ::close(current);
+	}
+};
+inline wake_fd_holder wake_fd;
 }
+#endif
 
 inline void post_empty_event() {
 	glfwPostEmptyEvent();
+#ifdef GLFWHPP_REACTOR
+	int fd = detail::wake_fd.fd.load(std::memory_order_acquire);
+	if (fd >= 0) {
+		uint64_t one = 1;
+		[[maybe_unused]] auto written = ::write(fd, &one, sizeof(one));
+	}
+#endif
 }
 
 /* Time */
@@ -52,6 +128,74 @@ inline uint64_t time_raw() { return glfwGetTimerValue(); }
 inline uint64_t timer_frequency() { return glfwGetTimerFrequency(); }
 inline void set_current_time(double seconds) { glfwSetTime(seconds); }
 
+namespace detail {
+/* tick -> ns conversion, a single multiply when the timer frequency divides 1e9 (the common case) */
+struct tick_conversion {
+	static constexpr uint64_t NS_PER_SECOND = 1'000'000'000;
+
+	explicit tick_conversion(uint64_t timerFrequency) : frequency(timerFrequency) {
+		if (frequency == 0) frequency = NS_PER_SECOND;
+		multiplier = NS_PER_SECOND % frequency == 0 ? NS_PER_SECOND / frequency : 0;
+	}
+
+	int64_t to_ns(uint64_t ticks) const {
+		if (multiplier) return static_cast<int64_t>(ticks * multiplier);
+		return static_cast<int64_t>(ticks / frequency * NS_PER_SECOND + ticks % frequency * NS_PER_SECOND / frequency);
+	}
+	uint64_t to_ticks(int64_t ns) const {
+		auto value = static_cast<uint64_t>(ns);
+		if (multiplier) return value / multiplier;
+		return value / NS_PER_SECOND * frequency + value % NS_PER_SECOND * frequency / NS_PER_SECOND;
+	}
+
+	uint64_t frequency;
+	uint64_t multiplier;
+};
+
+/* built by the first call after glfwInit, before that GLFW has no frequency and the uncached 1e9 fallback is used */
+inline tick_conversion const& ticks() {
+	static std::atomic<tick_conversion const*> cached{ nullptr };
+	if (auto conversion = cached.load(std::memory_order_acquire)) return *conversion;
+	uint64_t frequency = glfwGetTimerFrequency();
+	if (frequency == 0) {
+		static tick_conversion const fallback{ tick_conversion::NS_PER_SECOND };
+		return fallback;
+	}
+	static tick_conversion const conversion{ frequency };
+	cached.store(&conversion, std::memory_order_release);
+	return conversion;
+}
+
+inline std::atomic<int64_t> clock_offset{ 0 };
+}
+
+/* std::chrono clock over glfwGetTimerValue with integer nanosecond durations, never goes through double.
+ * Not steady: set_current_time can move it backwards, differences of raw timestamps (to_duration) are unaffected. */
+struct clock {
+	using rep = int64_t;
+	using period = std::nano;
+	using duration = std::chrono::nanoseconds;
+	using time_point = std::chrono::time_point<clock>;
+	static constexpr bool is_steady = false;
+
+	static time_point now() noexcept { return from_ticks(glfwGetTimerValue()); }
+
+	/* raw timer values as returned by time_raw, e.g. event timestamps */
+	static time_point from_ticks(uint64_t ticks) noexcept {
+		return time_point{ duration{ detail::ticks().to_ns(ticks) + detail::clock_offset.load(std::memory_order_relaxed) } };
+	}
+	static uint64_t to_ticks(time_point timePoint) noexcept {
+		return detail::ticks().to_ticks(timePoint.time_since_epoch().count() - detail::clock_offset.load(std::memory_order_relaxed));
+	}
+	static duration to_duration(uint64_t ticks) noexcept { return duration{ detail::ticks().to_ns(ticks) }; }
+};
+
+/* offsets glfw::clock so that now() returns timePoint, independent of the double based time() */
+inline void set_current_time(clock::time_point timePoint) {
+	auto current = detail::ticks().to_ns(glfwGetTimerValue());
+	detail::clock_offset.store(timePoint.time_since_epoch().count() - current, std::memory_order_relaxed);
+}
+
 /* Clipboard Utility */
 std::string_view clip_text() {
 	char const* text = glfwGetClipboardString(nullptr);
@@ -80,28 +224,70 @@ struct init_hint {
 	bool hintEnabled;
 };
 
+/* Platform selection, GLFW 3.4+ */
+#ifdef GLFW_PLATFORM
+enum class platform_type : int {
+	Any = GLFW_ANY_PLATFORM,
+	Win32 = GLFW_PLATFORM_WIN32,
+	Cocoa = GLFW_PLATFORM_COCOA,
+	Wayland = GLFW_PLATFORM_WAYLAND,
+	X11 = GLFW_PLATFORM_X11,
+	/* no display, windows and monitors are simulated - for tests and CI machines */
+	Null = GLFW_PLATFORM_NULL,
+};
+
+struct platform_hint {
+	platform_type platform;
+};
+
+inline bool is_platform_supported(platform_type platform) { return glfwPlatformSupported(static_cast<int>(platform)) == GLFW_TRUE; }
+/* platform GLFW was initialized with */
+inline platform_type current_platform() { return platform_type{ glfwGetPlatform() }; }
+#endif
+
 namespace detail {
 struct lib {
-	glfw_lib() {
+	lib() {
 		if (!glfwInit()) throw std::runtime_error("Failed to init GLFW");
 	}
-	~glfw_lib() {
+	~lib() {
 		glfwTerminate();
 	}
 };
 
 }
 
+namespace detail {
+inline void apply_init_hint(init_hint initHint) { glfwInitHint(static_cast<int>(initHint.hint), initHint.hintEnabled ? glfw::TRUE : glfw::FALSE); }
+#ifdef GLFW_PLATFORM
+inline void apply_init_hint(platform_hint platformHint) { glfwInitHint(GLFW_PLATFORM, static_cast<int>(platformHint.platform)); }
+
+template<class T>
+inline constexpr bool is_init_hint_v = std::is_same_v<init_hint, T> || std::is_same_v<platform_hint, T>;
+#else
+template<class T>
+inline constexpr bool is_init_hint_v = std::is_same_v<init_hint, T>;
+#endif
+}
+
 template<class ...hints>
 inline void init_hints(hints... initHints) {
-	static_assert((std::is_same_v<init_hint, hints> && ...));
-	(glfwInitHint(static_cast<int>(initHints.hint), initHints.hintEnabled ? glfw::TRUE : glfw::FALSE), ...);
+	static_assert((detail::is_init_hint_v<hints> && ...));
+	(detail::apply_init_hint(initHints), ...);
 }
 
 inline void init() {
 	static detail::lib libInstance;
 }
 
+#ifdef GLFW_PLATFORM
+/* init on a specific platform, e.g. platform_type::Null for display-less machines. Only the first init call initializes GLFW */
+inline void init(platform_type platform) {
+	init_hints(platform_hint{ platform });
+	init();
+}
+#endif
+
 #ifdef GLFWHPP_AUTO_INIT
 namespace detail {
 struct glfw_lib_auto_init {
@@ -193,12 +379,31 @@ struct video_mode {
 	monitor_color_depth color;
 };
 
+/* snapshot of one monitor, see monitor_registry */
+struct monitor_info {
+	GLFWmonitor* handle;
+	/* GLFW's copy of the name, valid until the monitor is disconnected like monitor::name, refreshes keep it */
+	std::string_view name;
+	video_mode current_mode;
+	monitor_size physical_size;
+	monitor_content_scale content_scale;
+	monitor_position virtual_position;
+	monitor_work_area work_area;
+	bool primary;
+};
+
+namespace detail {
+/* nullptr unless monitor_registry is enabled and knows the monitor */
+inline monitor_info const* find_monitor_info(GLFWmonitor*);
+}
+
 class monitor {
 public:
 	explicit monitor(GLFWmonitor* handle) : m_handle(handle) {};
 
-	monitor(monitor const&) = delete;
-	monitor& operator=(monitor const&) = delete;
+	//monitor is a non-owning handle
+	monitor(monitor const&) = default;
+	monitor& operator=(monitor const&) = default;
 
 	monitor(monitor&& other) : m_handle(std::exchange(other.m_handle, nullptr)) {}
 	monitor& operator=(monitor&& other) {
@@ -206,23 +411,14 @@ public:
 		return *this;
 	}
 
-	static monitor get_primary_monitor() {
-		return monitor{ glfwGetPrimaryMonitor() };
-	}
+	static monitor get_primary_monitor();
 
-	static std::vector<monitor> get_monitors() {
-		int count = 0;
-		GLFWmonitor** monitorHandles = glfwGetMonitors(&count);
-		auto monitors = std::vector<monitor>{};
-		monitors.reserve(count);
-		for (int i = 0; i < count; ++i) {
-			monitors.emplace_back(monitorHandles[i]);
-		}
-		return monitors;
-	}
+	/* allocates the returned vector, with monitor_registry enabled monitor_registry::monitors() lists them without allocating */
+	static std::vector<monitor> get_monitors();
 
 
 	video_mode get_current_video_mode() const {
+		if (auto info = detail::find_monitor_info(m_handle)) return info->current_mode;
 		GLFWvidmode const* curMode = glfwGetVideoMode(m_handle);
 		return { {curMode->width, curMode->height},{curMode->refreshRate}, {curMode->redBits, curMode->greenBits, curMode->blueBits} };
 	}
@@ -239,30 +435,35 @@ public:
 	}
 
 	monitor_size get_physical_size()  const {
+		if (auto info = detail::find_monitor_info(m_handle)) return info->physical_size;
 		monitor_size size;
 		glfwGetMonitorPhysicalSize(m_handle, &size.width, &size.height);
 		return size;
 	}
 
 	monitor_content_scale get_content_Scale() const {
+		if (auto info = detail::find_monitor_info(m_handle)) return info->content_scale;
 		monitor_content_scale scale;
 		glfwGetMonitorContentScale(m_handle, &scale.xScale, &scale.yScale);
 		return scale;
 	}
 
 	monitor_position get_virtual_position() const {
+		if (auto info = detail::find_monitor_info(m_handle)) return info->virtual_position;
 		monitor_position pos;
 		glfwGetMonitorPos(m_handle, &pos.x, &pos.y);
 		return pos;
 	}
 
 	monitor_work_area get_work_area() const {
+		if (auto info = detail::find_monitor_info(m_handle)) return info->work_area;
 		monitor_work_area workArea;
 		glfwGetMonitorWorkarea(m_handle, &workArea.x, &workArea.y, &workArea.width, &workArea.height);
 		return workArea;
 	}
 
 	std::string_view name() const {
+		if (auto info = detail::find_monitor_info(m_handle)) return info->name;
 		char const* name = glfwGetMonitorName(m_handle);
 		if (name) return std::string_view{ name };
 		return std::string_view{};
@@ -291,6 +492,73 @@ private:
 	GLFWmonitor* m_handle;
 };
 
+namespace detail {
+struct monitor_registry_state {
+	bool enabled = false;
+	uint64_t generation = 0;
+	std::vector<monitor_info> monitors;
+};
+
+inline monitor_registry_state monitor_registry;
+
+/* reuses the snapshot storage, only a grown monitor count allocates */
+inline void refresh_monitor_registry() {
+	int count = 0;
+	GLFWmonitor** handles = glfwGetMonitors(&count);
+	GLFWmonitor* primary = glfwGetPrimaryMonitor();
+	auto& monitors = monitor_registry.monitors;
+	monitors.resize(static_cast<size_t>(count));
+	for (int i = 0; i < count; ++i) {
+		auto& info = monitors[i];
+		info.handle = handles[i];
+		char const* name = glfwGetMonitorName(handles[i]);
+		info.name = name ? std::string_view{ name } : std::string_view{};
+		GLFWvidmode const* mode = glfwGetVideoMode(handles[i]);
+		info.current_mode = mode ? video_mode{ { mode->width, mode->height }, { mode->refreshRate }, { mode->redBits, mode->greenBits, mode->blueBits } } : video_mode{};
+		glfwGetMonitorPhysicalSize(handles[i], &info.physical_size.width, &info.physical_size.height);
+		glfwGetMonitorContentScale(handles[i], &info.content_scale.xScale, &info.content_scale.yScale);
+		glfwGetMonitorPos(handles[i], &info.virtual_position.x, &info.virtual_position.y);
+		glfwGetMonitorWorkarea(handles[i], &info.work_area.x, &info.work_area.y, &info.work_area.width, &info.work_area.height);
+		info.primary = handles[i] == primary;
+	}
+	++monitor_registry.generation;
+}
+
+inline monitor_info const* find_monitor_info(GLFWmonitor* handle) {
+	if (!monitor_registry.enabled) return nullptr;
+	for (auto const& info : monitor_registry.monitors) {
+		if (info.handle == handle) return &info;
+	}
+	return nullptr;
+}
+}
+
+inline monitor monitor::get_primary_monitor() {
+	if (detail::monitor_registry.enabled) {
+		for (auto const& info : detail::monitor_registry.monitors) {
+			if (info.primary) return monitor{ info.handle };
+		}
+		return monitor{ nullptr };
+	}
+	return monitor{ glfwGetPrimaryMonitor() };
+}
+
+inline std::vector<monitor> monitor::get_monitors() {
+	auto monitors = std::vector<monitor>{};
+	if (detail::monitor_registry.enabled) {
+		monitors.reserve(detail::monitor_registry.monitors.size());
+		for (auto const& info : detail::monitor_registry.monitors) monitors.emplace_back(info.handle);
+		return monitors;
+	}
+	int count = 0;
+	GLFWmonitor** monitorHandles = glfwGetMonitors(&count);
+	monitors.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		monitors.emplace_back(monitorHandles[i]);
+	}
+	return monitors;
+}
+
 /************************************************************************************
  *																					*
  *									 WINDOW											*
@@ -492,6 +760,16 @@ struct aspect_ratio {
 	int num, denom;
 };
 
+/* snapshot of glfw::cached_geometry, generation changes whenever one of the values does */
+struct window_geometry {
+	window_position position;
+	window_size size;
+	framebuffer_size framebuffer;
+	window_frame frame;
+	window_content_scale scale;
+	uint64_t generation;
+};
+
 enum window_event_type : uint16_t {
 	POSITION_CHANGED = 1 << 0,
 	SIZE_CHANGED = 1 << 1,
@@ -516,6 +794,24 @@ template<class KeyCallback>
 inline void set_key_callback(GLFWwindow*, KeyCallback&&);
 inline void set_key_callback(GLFWwindow*, std::nullptr_t);
 }
+namespace detail::callbacks {
+struct window_callbacks;
+inline window_callbacks* find(GLFWwindow*);
+inline window_callbacks& acquire(GLFWwindow*);
+/* acquire for windows created by glfw::window */
+inline void acquire_owned(GLFWwindow*);
+inline void release(GLFWwindow*);
+inline void* get_user_pointer(GLFWwindow*);
+inline void set_user_pointer(GLFWwindow*, void*);
+}
+namespace detail {
+inline void swap_buffers(GLFWwindow*);
+/* glfwGetWindowAttrib, answered from the mirrored state for windows with cached_state enabled */
+inline bool get_attribute(GLFWwindow*, int attribute);
+inline void set_visible(GLFWwindow*, bool visible);
+/* nullptr unless cached_geometry is enabled for the window */
+inline window_geometry const* find_geometry(GLFWwindow*);
+}
 /* TODO: add set_xxx_callback to window api */
 
 class window {
@@ -530,6 +826,8 @@ public:
 		GLFWmonitor* fsLoc = fullscreenLocation ? fullscreenLocation.value() : (GLFWmonitor*)nullptr;
 		GLFWwindow* share = sharedContext ? sharedContext->m_handle : nullptr;
 		m_handle = glfwCreateWindow(size.width, size.height, title, fsLoc, share);
+		//create the callback block up front so registering callbacks never allocates
+		if (m_handle) detail::callbacks::acquire_owned(m_handle);
 	}
 	//window is a unique handle
 	window(window const&) = delete;
@@ -537,11 +835,16 @@ public:
 	//window handle is movable
 	window(window&& w) noexcept : m_handle(w.m_handle) { w.m_handle = nullptr; }
 	window& operator=(window&& w) noexcept {
-		m_handle = w.m_handle;
-		w.m_handle = nullptr;
-	};
+		if (this != &w) {
+			detail::callbacks::release(m_handle);
+			glfwDestroyWindow(m_handle);
+			m_handle = std::exchange(w.m_handle, nullptr);
+		}
+		return *this;
+	}
 
 	~window() {
+		detail::callbacks::release(m_handle);
 		glfwDestroyWindow(m_handle);
 	}
 
@@ -563,23 +866,23 @@ public:
 
 	void minimize() { glfwIconifyWindow(m_handle); }
 
-	bool is_minimized() const { return glfwGetWindowAttrib(m_handle, GLFW_ICONIFIED) == glfw::TRUE; }
+	bool is_minimized() const { return detail::get_attribute(m_handle, GLFW_ICONIFIED); }
 
 	void maximize() { glfwMaximizeWindow(m_handle); }
 
-	bool is_maximized() const { return glfwGetWindowAttrib(m_handle, GLFW_MAXIMIZED) == glfw::TRUE; }
+	bool is_maximized() const { return detail::get_attribute(m_handle, GLFW_MAXIMIZED); }
 
 	void restore() { glfwRestoreWindow(m_handle); }
 
-	void hide() { glfwHideWindow(m_handle); }
+	void hide() { detail::set_visible(m_handle, false); }
 
-	void show() { glfwShowWindow(m_handle); }
+	void show() { detail::set_visible(m_handle, true); }
 
-	bool is_visible() const { return glfwGetWindowAttrib(m_handle, GLFW_VISIBLE) == glfw::TRUE; }
+	bool is_visible() const { return detail::get_attribute(m_handle, GLFW_VISIBLE); }
 
 	void set_focus() { glfwFocusWindow(m_handle); }
 
-	bool has_focus() const { return glfwGetWindowAttrib(m_handle, GLFW_FOCUSED) == glfw::TRUE; }
+	bool has_focus() const { return detail::get_attribute(m_handle, GLFW_FOCUSED); }
 
 	void request_attention() { glfwRequestWindowAttention(m_handle); }
 
@@ -607,7 +910,7 @@ public:
 
 	void set_close_request(bool enabled = true) { glfwSetWindowShouldClose(m_handle, enabled ? glfw::TRUE : glfw::FALSE); }
 
-	bool is_hovered() const { return glfwGetWindowAttrib(m_handle, GLFW_HOVERED) == glfw::TRUE; }
+	bool is_hovered() const { return detail::get_attribute(m_handle, GLFW_HOVERED); }
 
 	client_api_type get_client_api() const {
 		return client_api_type{ glfwGetWindowAttrib(m_handle, GLFW_CLIENT_API) };
@@ -629,44 +932,53 @@ public:
 
 	void set_cursor(cursor newCursor) { glfwSetCursor(m_handle, newCursor); }
 
+	/* The GLFW user pointer is owned by the wrapper for callback dispatch, use these instead of glfwSetWindowUserPointer */
 	template<class T>
-	T* get_user_pointer() const { return static_cast<T*>(glfwGetWindowUserPointer(m_handle)); }
+	T* get_user_pointer() const { return static_cast<T*>(detail::callbacks::get_user_pointer(m_handle)); }
 
 	template<class T>
-	T set_user_pointer(T userPointer) {
+	void set_user_pointer(T userPointer) {
 		static_assert(std::is_pointer_v<T>, "set_user_pointer only accepts pointer types");
-		glfwSetWindowUserPointer(m_handle, static_cast<void*>(userPointer));
+		detail::callbacks::set_user_pointer(m_handle, static_cast<void*>(userPointer));
 	}
 
 	void resize(window_size size) { glfwSetWindowSize(m_handle, size.width, size.height); }
 
 	window_size size() const {
+		if (auto geometry = detail::find_geometry(m_handle)) return geometry->size;
 		window_size size;
 		glfwGetWindowSize(m_handle, &size.width, &size.height);
 		return size;
 	}
 
 	window_frame get_window_frame() const {
+		if (auto geometry = detail::find_geometry(m_handle)) return geometry->frame;
 		window_frame frame;
 		glfwGetWindowFrameSize(m_handle, &frame.left, &frame.top, &frame.right, &frame.bottom);
 		return frame;
 	}
 
 	framebuffer_size get_framebuffer_size() const {
-		framebuffer fb;
+		if (auto geometry = detail::find_geometry(m_handle)) return geometry->framebuffer;
+		framebuffer_size fb;
 		glfwGetFramebufferSize(m_handle, &fb.width, &fb.height);
 		return fb;
 	}
 
 	bool has_framebuffer_alpha() const { return glfwGetWindowAttrib(m_handle, GLFW_TRANSPARENT_FRAMEBUFFER) == glfw::TRUE; }
 
-	void swap_buffers() { glfwSwapBuffers(m_handle); }
+	void swap_buffers() { detail::swap_buffers(m_handle); }
+
+	void make_context_current() { glfwMakeContextCurrent(m_handle); }
+
+	bool is_context_current() const { return glfwGetCurrentContext() == m_handle; }
 
 	float get_opacity() const { return glfwGetWindowOpacity(m_handle); }
 
 	void set_opacity(float opacity) { glfwSetWindowOpacity(m_handle, opacity); }
 
 	window_content_scale get_content_scale() const {
+		if (auto geometry = detail::find_geometry(m_handle)) return geometry->scale;
 		window_content_scale scale;
 		glfwGetWindowContentScale(m_handle, &scale.xScale, &scale.yScale);
 		return scale;
@@ -677,6 +989,7 @@ public:
 	void set_aspect_ratio(aspect_ratio aspect) { glfwSetWindowAspectRatio(m_handle, aspect.num, aspect.denom); }
 
 	window_position get_position() const {
+		if (auto geometry = detail::find_geometry(m_handle)) return geometry->position;
 		window_position pos;
 		glfwGetWindowPos(m_handle, &pos.x, &pos.y);
 		return pos;
@@ -698,10 +1011,10 @@ public:
 	void set_event_callback(std::nullptr_t) { window_events::set_event_callback(m_handle, nullptr); }
 
 	template<class KeyCallback>
-	void set_key_callback(KeyCallback&& callback) { input::set_key_callback(m_handle, std::forward<KeyCallback>); }
+	void set_key_callback(KeyCallback&& callback) { input::set_key_callback(m_handle, std::forward<KeyCallback>(callback)); }
 	void set_key_callback(std::nullptr_t) { input::set_key_callback(m_handle, nullptr); }
 
-	operator GLFWwindow* () { return m_handle; }
+	operator GLFWwindow* () const { return m_handle; }
 private:
 	GLFWwindow* m_handle;
 };
@@ -718,7 +1031,7 @@ public:
 	using context_robustness_type = attributes::context_robustness_type;
 
 	explicit window_ref(GLFWwindow* window) : m_handle(window) {}
-	explicit window_ref(window window) : m_handle(window) {}
+	explicit window_ref(window const& window) : m_handle(window) {}
 
 	void make_fullscreen(monitor fsTargetMonitor, std::optional<video_mode> videoMode = std::nullopt) {
 		if (videoMode.has_value()) {
@@ -738,23 +1051,23 @@ public:
 
 	void minimize() { glfwIconifyWindow(m_handle); }
 
-	bool is_minimized() const { return glfwGetWindowAttrib(m_handle, GLFW_ICONIFIED) == glfw::TRUE; }
+	bool is_minimized() const { return detail::get_attribute(m_handle, GLFW_ICONIFIED); }
 
 	void maximize() { glfwMaximizeWindow(m_handle); }
 
-	bool is_maximized() const { return glfwGetWindowAttrib(m_handle, GLFW_MAXIMIZED) == glfw::TRUE; }
+	bool is_maximized() const { return detail::get_attribute(m_handle, GLFW_MAXIMIZED); }
 
 	void restore() { glfwRestoreWindow(m_handle); }
 
-	void hide() { glfwHideWindow(m_handle); }
+	void hide() { detail::set_visible(m_handle, false); }
 
-	void show() { glfwShowWindow(m_handle); }
+	void show() { detail::set_visible(m_handle, true); }
 
-	bool is_visible() const { return glfwGetWindowAttrib(m_handle, GLFW_VISIBLE) == glfw::TRUE; }
+	bool is_visible() const { return detail::get_attribute(m_handle, GLFW_VISIBLE); }
 
 	void set_focus() { glfwFocusWindow(m_handle); }
 
-	bool has_focus() const { return glfwGetWindowAttrib(m_handle, GLFW_FOCUSED) == glfw::TRUE; }
+	bool has_focus() const { return detail::get_attribute(m_handle, GLFW_FOCUSED); }
 
 	void request_attention() { glfwRequestWindowAttention(m_handle); }
 
@@ -782,7 +1095,7 @@ public:
 
 	void set_close_request(bool enabled = true) { glfwSetWindowShouldClose(m_handle, enabled ? glfw::TRUE : glfw::FALSE); }
 
-	bool is_hovered() const { return glfwGetWindowAttrib(m_handle, GLFW_HOVERED) == glfw::TRUE; }
+	bool is_hovered() const { return detail::get_attribute(m_handle, GLFW_HOVERED); }
 
 	client_api_type get_client_api() const {
 		return client_api_type{ glfwGetWindowAttrib(m_handle, GLFW_CLIENT_API) };
@@ -805,43 +1118,51 @@ public:
 	void set_cursor(cursor newCursor) { glfwSetCursor(m_handle, newCursor); }
 
 	template<class T>
-	T* get_user_pointer() const { return static_cast<T*>(glfwGetWindowUserPointer(m_handle));}
+	T* get_user_pointer() const { return static_cast<T*>(detail::callbacks::get_user_pointer(m_handle)); }
 
 	template<class T>
-	T set_user_pointer(T userPointer) {
+	void set_user_pointer(T userPointer) {
 		static_assert(std::is_pointer_v<T>, "set_user_pointer only accepts pointer types");
-		glfwSetWindowUserPointer(m_handle, static_cast<void*>(userPointer));
+		detail::callbacks::set_user_pointer(m_handle, static_cast<void*>(userPointer));
 	}
 
 	void resize(window_size size) { glfwSetWindowSize(m_handle, size.width, size.height); }
 
 	window_size size() const {
+		if (auto geometry = detail::find_geometry(m_handle)) return geometry->size;
 		window_size size;
 		glfwGetWindowSize(m_handle, &size.width, &size.height);
 		return size;
 	}
 
 	window_frame get_window_frame() const {
+		if (auto geometry = detail::find_geometry(m_handle)) return geometry->frame;
 		window_frame frame;
 		glfwGetWindowFrameSize(m_handle, &frame.left, &frame.top, &frame.right, &frame.bottom);
 		return frame;
 	}
 
-	framebuffer get_framebuffer() const {
-		framebuffer fb;
+	framebuffer_size get_framebuffer_size() const {
+		if (auto geometry = detail::find_geometry(m_handle)) return geometry->framebuffer;
+		framebuffer_size fb;
 		glfwGetFramebufferSize(m_handle, &fb.width, &fb.height);
 		return fb;
 	}
 
 	bool has_framebuffer_alpha() const { return glfwGetWindowAttrib(m_handle, GLFW_TRANSPARENT_FRAMEBUFFER) == glfw::TRUE; }
 
-	void swap_buffers() { glfwSwapBuffers(m_handle); }
+	void swap_buffers() { detail::swap_buffers(m_handle); }
+
+	void make_context_current() { glfwMakeContextCurrent(m_handle); }
+
+	bool is_context_current() const { return glfwGetCurrentContext() == m_handle; }
 
 	float get_opacity() const { return glfwGetWindowOpacity(m_handle); }
 
 	void set_opacity(float opacity) { glfwSetWindowOpacity(m_handle, opacity); }
 
 	window_content_scale get_content_scale() const {
+		if (auto geometry = detail::find_geometry(m_handle)) return geometry->scale;
 		window_content_scale scale;
 		glfwGetWindowContentScale(m_handle, &scale.xScale, &scale.yScale);
 		return scale;
@@ -852,6 +1173,7 @@ public:
 	void set_aspect_ratio(aspect_ratio aspect) { glfwSetWindowAspectRatio(m_handle, aspect.num, aspect.denom); }
 
 	window_position get_position() const {
+		if (auto geometry = detail::find_geometry(m_handle)) return geometry->position;
 		window_position pos;
 		glfwGetWindowPos(m_handle, &pos.x, &pos.y);
 		return pos;
@@ -873,9 +1195,10 @@ public:
 	void set_event_callback(std::nullptr_t) { window_events::set_event_callback(m_handle, nullptr); }
 
 	template<class KeyCallback>
-	void set_key_callback(KeyCallback&& callback) { input::set_key_callback(m_handle, std::forward<KeyCallback>); }
+	void set_key_callback(KeyCallback&& callback) { input::set_key_callback(m_handle, std::forward<KeyCallback>(callback)); }
 	void set_key_callback(std::nullptr_t) { input::set_key_callback(m_handle, nullptr); }
 
+	operator GLFWwindow* () const { return m_handle; }
 private:
 	GLFWwindow* m_handle;
 };
@@ -927,58 +1250,725 @@ private:
 	std::vector<attributes::window_hints> m_hints;
 };
 
+/* static window builder: hint and value are part of the type, hints are checked at compile time and only the ones
+ * differing from the GLFW defaults are set. Like window_builder it expects the hints at their defaults before create. */
+
+namespace detail {
+/* glfwDefaultWindowHints values */
+constexpr int default_hint_value(int hint) {
+	switch (hint) {
+	case GLFW_RESIZABLE: case GLFW_VISIBLE: case GLFW_DECORATED: case GLFW_FOCUSED: case GLFW_AUTO_ICONIFY:
+	case GLFW_CENTER_CURSOR: case GLFW_FOCUS_ON_SHOW: case GLFW_DOUBLEBUFFER: case GLFW_COCOA_RETINA_FRAMEBUFFER:
+		return GLFW_TRUE;
+	case GLFW_RED_BITS: case GLFW_GREEN_BITS: case GLFW_BLUE_BITS: case GLFW_ALPHA_BITS: case GLFW_STENCIL_BITS: return 8;
+	case GLFW_DEPTH_BITS: return 24;
+	case GLFW_REFRESH_RATE: return GLFW_DONT_CARE;
+	case GLFW_CONTEXT_VERSION_MAJOR: return 1;
+	case GLFW_CLIENT_API: return GLFW_OPENGL_API;
+	case GLFW_CONTEXT_CREATION_API: return GLFW_NATIVE_CONTEXT_API;
+	case GLFW_CONTEXT_ROBUSTNESS: return GLFW_NO_ROBUSTNESS;
+	case GLFW_OPENGL_PROFILE: return GLFW_OPENGL_ANY_PROFILE;
+	case GLFW_CONTEXT_RELEASE_BEHAVIOR: return GLFW_ANY_RELEASE_BEHAVIOR;
+	default: return 0;
+	}
+}
+
+template<int Hint, int Value>
+struct fixed_window_hint {
+	static constexpr int hint = Hint;
+	static constexpr int value = Value;
+	static constexpr bool is_default = Value == default_hint_value(Hint);
+};
+
+template<class T>
+inline constexpr bool is_fixed_window_hint_v = false;
+
+template<int Hint, int Value>
+inline constexpr bool is_fixed_window_hint_v<fixed_window_hint<Hint, Value>> = true;
+
+template<class ...Hints>
+constexpr bool has_fixed_hint(int hint) { return ((Hints::hint == hint) || ...); }
+
+template<class ...Hints>
+constexpr int fixed_hint_value(int hint) {
+	int value = default_hint_value(hint);
+	((Hints::hint == hint ? (value = Hints::value, 0) : 0), ...);
+	return value;
+}
+
+template<class ...Hints>
+constexpr bool unique_fixed_hints() {
+	constexpr int hints[] = { Hints::hint..., 0 };
+	for (size_t i = 0; i < sizeof...(Hints); ++i) {
+		for (size_t j = i + 1; j < sizeof...(Hints); ++j) {
+			if (hints[i] == hints[j]) return false;
+		}
+	}
+	return true;
+}
+
+template<class ...Hints>
+constexpr bool has_context_hints() {
+	return has_fixed_hint<Hints...>(GLFW_CONTEXT_VERSION_MAJOR) || has_fixed_hint<Hints...>(GLFW_CONTEXT_VERSION_MINOR)
+		|| has_fixed_hint<Hints...>(GLFW_OPENGL_PROFILE) || has_fixed_hint<Hints...>(GLFW_OPENGL_FORWARD_COMPAT)
+		|| has_fixed_hint<Hints...>(GLFW_OPENGL_DEBUG_CONTEXT) || has_fixed_hint<Hints...>(GLFW_CONTEXT_ROBUSTNESS)
+		|| has_fixed_hint<Hints...>(GLFW_CONTEXT_RELEASE_BEHAVIOR) || has_fixed_hint<Hints...>(GLFW_CONTEXT_CREATION_API)
+		|| has_fixed_hint<Hints...>(GLFW_CONTEXT_NO_ERROR);
+}
+}
+
+namespace attributes {
+template<hint_type Hint, bool Enabled>
+using fixed_hint = detail::fixed_window_hint<static_cast<int>(Hint), Enabled ? GLFW_TRUE : GLFW_FALSE>;
+
+template<value_hint_type Hint, int Value>
+using fixed_value_hint = detail::fixed_window_hint<static_cast<int>(Hint), Value>;
+
+template<client_api_type Api>
+using fixed_client_api_hint = detail::fixed_window_hint<GLFW_CLIENT_API, static_cast<int>(Api)>;
+
+template<context_creation_api_type Api>
+using fixed_context_creation_api_hint = detail::fixed_window_hint<GLFW_CONTEXT_CREATION_API, static_cast<int>(Api)>;
+
+template<context_robustness_type Robustness>
+using fixed_robustness_hint = detail::fixed_window_hint<GLFW_CONTEXT_ROBUSTNESS, static_cast<int>(Robustness)>;
+
+template<opengl_profile_type Profile>
+using fixed_opengl_profile_hint = detail::fixed_window_hint<GLFW_OPENGL_PROFILE, static_cast<int>(Profile)>;
+
+template<context_release_behaviour_type Behaviour>
+using fixed_context_release_behaviour_hint = detail::fixed_window_hint<GLFW_CONTEXT_RELEASE_BEHAVIOR, static_cast<int>(Behaviour)>;
+}
+
+/* String hints need runtime storage and stay with window_builder. The builder holds no state and allocates nothing
+ * for its hints, the window it creates still allocates its callback block like any glfw::window. One builder stamps
+ * out any number of windows:
+ *	static_window_builder<fixed_client_api_hint<client_api_type::None>, fixed_hint<hint_type::Resizable, false>> builder;
+ *	auto window = builder.create({ 640, 480 }, "title"); */
+template<class ...Hints>
+class static_window_builder {
+	static_assert((detail::is_fixed_window_hint_v<Hints> && ...), "static_window_builder takes attributes::fixed_* hints");
+	static_assert(detail::unique_fixed_hints<Hints...>(), "window hint set more than once");
+	static_assert(detail::fixed_hint_value<Hints...>(GLFW_CLIENT_API) != GLFW_NO_API || !detail::has_context_hints<Hints...>(),
+		"context hints given for a window without client API");
+	static_assert(!detail::has_fixed_hint<Hints...>(GLFW_OPENGL_PROFILE) || detail::fixed_hint_value<Hints...>(GLFW_CLIENT_API) == GLFW_OPENGL_API,
+		"OpenGL profiles only apply to desktop OpenGL");
+	static_assert(detail::fixed_hint_value<Hints...>(GLFW_OPENGL_PROFILE) == GLFW_OPENGL_ANY_PROFILE
+		|| detail::fixed_hint_value<Hints...>(GLFW_CONTEXT_VERSION_MAJOR) * 10 + detail::fixed_hint_value<Hints...>(GLFW_CONTEXT_VERSION_MINOR) >= 32,
+		"core and compatibility profiles need context version 3.2 or later");
+	static_assert(!detail::has_fixed_hint<Hints...>(GLFW_OPENGL_FORWARD_COMPAT) || detail::fixed_hint_value<Hints...>(GLFW_CLIENT_API) == GLFW_OPENGL_API,
+		"forward compatibility only applies to desktop OpenGL");
+public:
+	constexpr static_window_builder() = default;
+	constexpr explicit static_window_builder(Hints...) {}
+
+	/* number of glfwWindowHint calls create makes before the window, the same number restore the defaults after */
+	static constexpr size_t applied_hints = (size_t{ 0 } + ... + (Hints::is_default ? 0 : 1));
+
+	window create(window_size size, char const* title, std::optional<monitor> fullscreenLocation = std::nullopt, window* sharedContext = nullptr) const {
+		(apply<Hints>(Hints::value), ...);
+		auto win = window{ size, title, fullscreenLocation, sharedContext };
+		(apply<Hints>(detail::default_hint_value(Hints::hint)), ...);
+		return win;
+	}
+private:
+	template<class Hint>
+	static void apply(int value) {
+		if constexpr (!Hint::is_default) glfwWindowHint(Hint::hint, value);
+	}
+};
+
 /************************************************************************************
  *																					*
- *								EVENTS & CALLBACKS									*
+ *								CALLBACK STORAGE									*
  *																					*
  ************************************************************************************/
 
-enum class monitor_event_type : int {
-	Connected = GLFW_CONNECTED,
-	Disconnected = GLFW_DISCONNECTED,
+#ifndef GLFWHPP_CALLBACK_CAPACITY
+#define GLFWHPP_CALLBACK_CAPACITY 32
+#endif
+
+/* Fixed-capacity callable stored inline, used for all registered callbacks.
+ * Construction and invocation never allocate, callables exceeding the capacity are rejected at compile time. */
+template<class Signature, size_t Capacity = GLFWHPP_CALLBACK_CAPACITY>
+class inplace_function;
+
+template<class R, class ...Args, size_t Capacity>
+class inplace_function<R(Args...), Capacity> {
+	template<class F>
+	using enable_if_callable = std::enable_if_t<!std::is_same_v<std::decay_t<F>, inplace_function> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>>;
+public:
+	static constexpr size_t capacity = Capacity;
+	static constexpr size_t alignment = alignof(std::max_align_t);
+
+	inplace_function() noexcept = default;
+	inplace_function(std::nullptr_t) noexcept {}
+
+	template<class F, class = enable_if_callable<F>>
+	inplace_function(F&& callable) {
+		using callable_t = std::decay_t<F>;
+		static_assert(sizeof(callable_t) <= Capacity, "callable is too large for inplace_function, reduce its captures or raise GLFWHPP_CALLBACK_CAPACITY");
+		static_assert(alignof(callable_t) <= alignment, "callable is over-aligned for inplace_function");
+		static_assert(std::is_nothrow_move_constructible_v<callable_t>, "inplace_function requires nothrow movable callables");
+		::new (static_cast<void*>(m_storage)) callable_t(std::forward<F>(callable));
+		m_invoke = &invoke<callable_t>;
+		m_manage = std::is_trivially_copyable_v<callable_t> ? nullptr : &manage<callable_t>;
+	}
+
+	inplace_function(inplace_function&& other) noexcept { move_from(other); }
+	inplace_function& operator=(inplace_function&& other) noexcept {
+		if (this != &other) {
+			reset();
+			move_from(other);
+		}
+		return *this;
+	}
+
+	inplace_function& operator=(std::nullptr_t) noexcept {
+		reset();
+		return *this;
+	}
+
+	template<class F, class = enable_if_callable<F>>
+	inplace_function& operator=(F&& callable) { return *this = inplace_function{ std::forward<F>(callable) }; }
+
+	inplace_function(inplace_function const&) = delete;
+	inplace_function& operator=(inplace_function const&) = delete;
+
+	~inplace_function() { reset(); }
+
+	R operator()(Args... args) const { return m_invoke(m_storage, std::forward<Args>(args)...); }
+
+	explicit operator bool() const noexcept { return m_invoke != nullptr; }
+
+private:
+	enum class operation { Move, Destroy };
+
+	template<class F>
+	static R invoke(void* storage, Args&&... args) { return std::invoke(*static_cast<F*>(storage), std::forward<Args>(args)...); }
+
+	template<class F>
+	static void manage(operation op, void* storage, void* source) {
+		if (op == operation::Move) ::new (storage) F(std::move(*static_cast<F*>(source)));
+		static_cast<F*>(op == operation::Move ? source : storage)->~F();
+	}
+
+	void move_from(inplace_function& other) noexcept {
+		if (!other.m_invoke) return;
+		if (other.m_manage) other.m_manage(operation::Move, m_storage, other.m_storage);
+		else std::memcpy(m_storage, other.m_storage, Capacity);
+		m_invoke = std::exchange(other.m_invoke, nullptr);
+		m_manage = std::exchange(other.m_manage, nullptr);
+	}
+
+	void reset() noexcept {
+		if (m_manage) m_manage(operation::Destroy, m_storage, nullptr);
+		m_invoke = nullptr;
+		m_manage = nullptr;
+	}
+
+	alignas(alignment) mutable std::byte m_storage[Capacity] = {};
+	R(*m_invoke)(void*, Args&&...) = nullptr;
+	void(*m_manage)(operation, void*, void*) = nullptr;
 };
 
-struct monitor_event {
-	monitor monitorObject;
-	monitor_event_type monitorStatus;
+/* Non-owning callable reference, the referenced callable has to outlive every invocation.
+ * Fits into any inplace_function, use it to register callables with large state without copying them. */
+template<class Signature>
+class function_ref;
+
+template<class R, class ...Args>
+class function_ref<R(Args...)> {
+public:
+	template<class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, function_ref> && std::is_invocable_r_v<R, F&, Args...>>>
+	function_ref(F&& callable) noexcept : m_invoke(&invoke<std::remove_reference_t<F>>) {
+		if constexpr (std::is_function_v<std::remove_reference_t<F>>) m_object = reinterpret_cast<void*>(&callable);
+		else m_object = const_cast<void*>(static_cast<void const*>(std::addressof(callable)));
+	}
+
+	R operator()(Args... args) const { return m_invoke(m_object, std::forward<Args>(args)...); }
+
+private:
+	template<class F>
+	static R invoke(void* object, Args&&... args) {
+		if constexpr (std::is_function_v<F>) return std::invoke(reinterpret_cast<F*>(object), std::forward<Args>(args)...);
+		else return std::invoke(*static_cast<F*>(object), std::forward<Args>(args)...);
+	}
+
+	void* m_object;
+	R(*m_invoke)(void*, Args&&...);
 };
 
-enum class error_type : int {
-	NoError = GLFW_NO_ERROR,
-	NotInitialized = GLFW_NOT_INITIALIZED,
-	NoCurrentContext = GLFW_NO_CURRENT_CONTEXT,
-	InvalidEnum = GLFW_INVALID_ENUM,
-	InvalidValue = GLFW_INVALID_VALUE,
-	OutOfMemory = GLFW_OUT_OF_MEMORY,
-	API_Unavailable = GLFW_API_UNAVAILABLE,
-	VersionUnavailable = GLFW_VERSION_UNAVAILABLE,
-	PlatformError = GLFW_PLATFORM_ERROR,
-	FormatUnavailable = GLFW_FORMAT_UNAVAILABLE,
-	NoWindowContext = GLFW_NO_WINDOW_CONTEXT,
+/************************************************************************************
+ *																					*
+ *								 CONTEXTS & THREADS									*
+ *																					*
+ ************************************************************************************/
+
+/* Makes a context current on this thread for the guard's lifetime, then restores the previous one */
+class context_guard {
+public:
+	explicit context_guard(GLFWwindow* window) : m_window(window), m_previous(glfwGetCurrentContext()) {
+		if (m_previous != m_window) glfwMakeContextCurrent(m_window);
+	}
+
+	~context_guard() {
+		if (m_previous != m_window) glfwMakeContextCurrent(m_previous);
+	}
+
+	context_guard(context_guard const&) = delete;
+	context_guard& operator=(context_guard const&) = delete;
+
+private:
+	GLFWwindow* m_window;
+	GLFWwindow* m_previous;
 };
 
-struct error {
-	error_type errorType;
-	std::string_view description;
+using frame_function = inplace_function<void(window_ref)>;
+
+class render_thread;
+
+namespace detail {
+/* the render_thread running on this thread, set for the whole run so stop requests from the frame function need no lookup */
+inline thread_local render_thread* current_render_thread = nullptr;
+}
+
+/* Dedicated thread owning a window's context: runs the frame function and swaps (windows without client API skip the swap)
+ * until stopped, while the main thread keeps polling. The frame function runs on the render thread, so it may only use the
+ * GLFW functions callable from any thread (context, swap, time) and has to synchronize its own data with the main thread.
+ * The context must not be current elsewhere, the constructor releases it when current on the calling thread.
+ * Must be stopped before the window is destroyed, render_threads::start ties it to the window for that. */
+class render_thread {
+public:
+	template<class FrameFunction>
+	render_thread(GLFWwindow* window, FrameFunction&& frame) : m_window(window), m_frame(std::forward<FrameFunction>(frame)) {
+		static_assert(std::is_invocable_v<FrameFunction, window_ref>);
+		m_swap = glfwGetWindowAttrib(window, GLFW_CLIENT_API) != GLFW_NO_API;
+		if (glfwGetCurrentContext() == window) glfwMakeContextCurrent(nullptr);
+		m_thread = std::thread{ [this] { run(); } };
+	}
+
+	~render_thread() { stop(); }
+
+	render_thread(render_thread const&) = delete;
+	render_thread& operator=(render_thread const&) = delete;
+
+	/* finishes the current frame and joins, the context is released on the render thread.
+	 * Called from the frame function it only requests the stop, the owner joins later (stop again or destroy). */
+	void stop() {
+		m_stop.store(true, std::memory_order_release);
+		if (!on_render_thread() && m_thread.joinable()) m_thread.join();
+	}
+
+	bool running() const { return m_thread.joinable() && !m_stop.load(std::memory_order_acquire); }
+
+	bool on_render_thread() const { return detail::current_render_thread == this; }
+
+	GLFWwindow* window() const { return m_window; }
+
+	uint64_t frames() const { return m_frames.load(std::memory_order_relaxed); }
+
+private:
+	void run() {
+		detail::current_render_thread = this;
+		glfwMakeContextCurrent(m_window);
+		while (!m_stop.load(std::memory_order_acquire)) {
+			m_frame(window_ref{ m_window });
+			if (m_swap) detail::swap_buffers(m_window);
+			m_frames.fetch_add(1, std::memory_order_relaxed);
+		}
+		glfwMakeContextCurrent(nullptr);
+		detail::current_render_thread = nullptr;
+	}
+
+	GLFWwindow* m_window;
+	frame_function m_frame;
+	bool m_swap = false;
+	std::atomic<bool> m_stop{ false };
+	std::atomic<uint64_t> m_frames{ 0 };
+	std::thread m_thread;
 };
 
+/************************************************************************************
+ *																					*
+ *								INSTRUMENTATION										*
+ *																					*
+ ************************************************************************************/
 
-enum class key : int {
-	SPACE = GLFW_KEY_SPACE,
-	APOSTROPHE = GLFW_KEY_APOSTROPHE,
-	COMMA = GLFW_KEY_COMMA,
-	MINUS = GLFW_KEY_MINUS,
-	PERIOD = GLFW_KEY_PERIOD,
-	SLASH = GLFW_KEY_SLASH,
-	K0 = GLFW_KEY_0,
-	K1 = GLFW_KEY_1,
-	K2 = GLFW_KEY_2,
-	K3 = GLFW_KEY_3,
-	K4 = GLFW_KEY_4,
-	K5 = GLFW_KEY_5,
-	K6 = GLFW_KEY_6,
-	K7 = GLFW_KEY_7,
-	K8 = GLFW_KEY_8,
+struct histogram_summary {
+	uint64_t count;
+	clock::duration p50, p99, p999, max;
+};
+
+/* Log-linear histogram over nanoseconds: 16 buckets per power of two, so values are kept within 1/16 of their magnitude.
+ * Recording is a relaxed atomic increment, safe from any thread. */
+class latency_histogram {
+public:
+	static constexpr uint32_t SUB_BUCKET_BITS = 4;
+	static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+	/* exact below SUB_BUCKETS ns, saturates at 2^44 ns (~4.9 hours) */
+	static constexpr size_t BUCKET_COUNT = (44 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+	void record(uint64_t ns) noexcept {
+		m_counts[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+		m_count.fetch_add(1, std::memory_order_relaxed);
+		uint64_t max = m_max.load(std::memory_order_relaxed);
+		while (ns > max && !m_max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+	}
+
+	uint64_t count() const noexcept { return m_count.load(std::memory_order_relaxed); }
+	clock::duration max() const noexcept { return clock::duration{ static_cast<int64_t>(m_max.load(std::memory_order_relaxed)) }; }
+
+	/* upper bound of the bucket holding the given quantile, 0 when empty */
+	clock::duration percentile(double quantile) const noexcept {
+		uint64_t total = count();
+		if (total == 0) return clock::duration{ 0 };
+		auto rank = static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(total)));
+		rank = std::clamp<uint64_t>(rank, 1, total);
+		uint64_t seen = 0;
+		for (size_t index = 0; index < BUCKET_COUNT; ++index) {
+			seen += m_counts[index].load(std::memory_order_relaxed);
+			if (seen >= rank) return clock::duration{ static_cast<int64_t>(std::min(bucket_upper_bound(index), m_max.load(std::memory_order_relaxed))) };
+		}
+		return max();
+	}
+
+	histogram_summary summary() const noexcept { return histogram_summary{ count(), percentile(0.5), percentile(0.99), percentile(0.999), max() }; }
+
+	void reset() noexcept {
+		for (auto& bucketCount : m_counts) bucketCount.store(0, std::memory_order_relaxed);
+		m_count.store(0, std::memory_order_relaxed);
+		m_max.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	static uint32_t highest_bit(uint64_t value) {
+		uint32_t bit = 0;
+		for (uint32_t shift = 32; shift; shift >>= 1) {
+			if (value >> shift) {
+				value >>= shift;
+				bit += shift;
+			}
+		}
+		return bit;
+	}
+	static size_t bucket(uint64_t value) {
+		if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+		uint32_t magnitude = highest_bit(value);
+		size_t index = (magnitude - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + ((value >> (magnitude - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+		return std::min(index, BUCKET_COUNT - 1);
+	}
+	static uint64_t bucket_upper_bound(size_t index) {
+		if (index < SUB_BUCKETS) return index;
+		uint32_t magnitude = static_cast<uint32_t>(index / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+		uint64_t width = uint64_t{ 1 } << (magnitude - SUB_BUCKET_BITS);
+		return (SUB_BUCKETS + index % SUB_BUCKETS) * width + width - 1;
+	}
+
+	std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_counts = {};
+	std::atomic<uint64_t> m_count{ 0 };
+	std::atomic<uint64_t> m_max{ 0 };
+};
+
+/* Input-to-present latency: consume() every input a frame acts on, frame_presented() right after its swap_buffers.
+ * Each frame is tagged with the oldest timestamp it consumed, frames without input are not recorded. */
+class input_latency_tracker {
+public:
+	void consume(uint64_t timestamp) noexcept {
+		if (timestamp && (m_oldest == 0 || timestamp < m_oldest)) m_oldest = timestamp;
+	}
+	template<class Event>
+	void consume(Event const& e) noexcept { consume(e.timestamp); }
+
+	/* oldest input of the frame in progress, 0 if none */
+	uint64_t frame_input_timestamp() const noexcept { return m_oldest; }
+
+	void frame_presented() noexcept { presented_at(glfwGetTimerValue()); }
+	void presented_at(uint64_t timestamp) noexcept {
+		if (m_oldest == 0) return;
+		auto latency = timestamp > m_oldest ? detail::ticks().to_ns(timestamp - m_oldest) : 0;
+		m_last = clock::duration{ latency };
+		m_histogram.record(static_cast<uint64_t>(latency));
+		m_oldest = 0;
+	}
+
+	clock::duration last_latency() const noexcept { return m_last; }
+	histogram_summary summary() const noexcept { return m_histogram.summary(); }
+	latency_histogram const& histogram() const noexcept { return m_histogram; }
+	void reset() noexcept {
+		m_histogram.reset();
+		m_oldest = 0;
+		m_last = clock::duration{ 0 };
+	}
+
+private:
+	uint64_t m_oldest = 0;
+	clock::duration m_last{ 0 };
+	latency_histogram m_histogram;
+};
+
+/* Opt-in with GLFWHPP_INSTRUMENTATION: poll_events / wait_events, swap_buffers and the registered callbacks
+ * are timed with the raw timer. Without it none of this is compiled and the wrapped calls are untouched. */
+#ifdef GLFWHPP_INSTRUMENTATION
+enum class metric : uint8_t {
+	/* time between two swap_buffers calls of a window */
+	Frame,
+	/* time spent in swap_buffers */
+	Swap,
+	/* time spent in glfwPollEvents / glfwWaitEvents, not per window */
+	Pump,
+	/* time spent in the registered callbacks of a window */
+	Callback,
+};
+
+namespace detail {
+struct window_metrics {
+	latency_histogram frame;
+	latency_histogram swap;
+	latency_histogram callback;
+	std::atomic<uint64_t> last_swap{ 0 };
+};
+
+inline latency_histogram pump_histogram;
+
+/* records the lifetime of the scope */
+class scoped_sample {
+public:
+	explicit scoped_sample(latency_histogram& histogram) : m_histogram(histogram), m_start(glfwGetTimerValue()) {}
+	~scoped_sample() { m_histogram.record(static_cast<uint64_t>(ticks().to_ns(glfwGetTimerValue() - m_start))); }
+
+	scoped_sample(scoped_sample const&) = delete;
+	scoped_sample& operator=(scoped_sample const&) = delete;
+
+private:
+	latency_histogram& m_histogram;
+	uint64_t m_start;
+};
+}
+#endif
+
+/************************************************************************************
+ *																					*
+ *								MAIN THREAD COMMANDS								*
+ *																					*
+ ************************************************************************************/
+
+#ifndef GLFWHPP_COMMAND_QUEUE_CAPACITY
+#define GLFWHPP_COMMAND_QUEUE_CAPACITY 1024
+#endif
+
+#ifndef GLFWHPP_COMMAND_CAPACITY
+#define GLFWHPP_COMMAND_CAPACITY 64
+#endif
+
+using main_thread_command = inplace_function<void(), GLFWHPP_COMMAND_CAPACITY>;
+
+struct command_queue_stats {
+	size_t depth;
+	size_t max_depth;
+	uint64_t posted;
+	uint64_t executed;
+	uint64_t rejected;
+	uint64_t wakeups;
+	/* first post of a burst to its drain, the wait of the oldest command */
+	histogram_summary latency;
+};
+
+/* Bounded lock-free queue, any thread posts, the thread calling poll_events / wait_events drains.
+ * A burst of posts between two drains wakes the event loop with a single post_empty_event. */
+template<size_t Capacity>
+class command_queue {
+	static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "command queue capacity must be a power of two");
+public:
+	command_queue() {
+		for (size_t i = 0; i < Capacity; ++i) m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	command_queue(command_queue const&) = delete;
+	command_queue& operator=(command_queue const&) = delete;
+
+	/* false when the queue is full, the command is dropped */
+	template<class Command>
+	bool post(Command&& command) {
+		static_assert(std::is_invocable_v<Command>);
+		size_t pos = m_tail.load(std::memory_order_relaxed);
+		cell* target;
+		for (;;) {
+			target = &m_cells[pos & (Capacity - 1)];
+			size_t sequence = target->sequence.load(std::memory_order_acquire);
+			auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+			if (diff == 0) {
+				if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			}
+			else if (diff < 0) {
+				m_rejected.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else pos = m_tail.load(std::memory_order_relaxed);
+		}
+		target->command = std::forward<Command>(command);
+		target->sequence.store(pos + 1, std::memory_order_release);
+
+		size_t head = m_head.load(std::memory_order_relaxed);
+		size_t depth = pos + 1 > head ? pos + 1 - head : 0;
+		size_t maxDepth = m_max_depth.load(std::memory_order_relaxed);
+		while (depth > maxDepth && !m_max_depth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed)) {}
+
+		if (!m_wake_pending.exchange(true, std::memory_order_acq_rel)) {
+			m_burst_start.store(glfwGetTimerValue(), std::memory_order_relaxed);
+			m_wakeups.fetch_add(1, std::memory_order_relaxed);
+			post_empty_event();
+		}
+		return true;
+	}
+
+	/* runs the posted commands on the draining thread, at most one queue worth so constant posting cannot hold the event loop */
+	size_t drain() {
+		//clearing first: a post racing with the drain either lands in it or sends a new wakeup
+		if (!m_wake_pending.exchange(false, std::memory_order_acq_rel)) return 0;
+		//0 when the post that won the wakeup has not stamped the burst yet, the sample is skipped
+		uint64_t burstStart = m_burst_start.exchange(0, std::memory_order_relaxed);
+		size_t count = 0;
+		size_t head = m_head.load(std::memory_order_relaxed);
+		for (; count < Capacity; ++count, ++head) {
+			cell& current = m_cells[head & (Capacity - 1)];
+			if (current.sequence.load(std::memory_order_acquire) != head + 1) break;
+			current.command();
+			current.command = nullptr;
+			current.sequence.store(head + Capacity, std::memory_order_release);
+			m_head.store(head + 1, std::memory_order_relaxed);
+		}
+		if (count && burstStart) {
+			uint64_t now = glfwGetTimerValue();
+			m_latency.record(static_cast<uint64_t>(detail::ticks().to_ns(now > burstStart ? now - burstStart : 0)));
+		}
+		//commands left behind by the cap get the next poll
+		if (count == Capacity && !m_wake_pending.exchange(true, std::memory_order_acq_rel)) post_empty_event();
+		return count;
+	}
+
+	size_t depth() const noexcept {
+		size_t head = m_head.load(std::memory_order_relaxed);
+		return m_tail.load(std::memory_order_relaxed) - head;
+	}
+
+	command_queue_stats stats() const noexcept {
+		return command_queue_stats{
+			depth(),
+			m_max_depth.load(std::memory_order_relaxed),
+			m_tail.load(std::memory_order_relaxed) - m_stats_base_tail.load(std::memory_order_relaxed),
+			m_head.load(std::memory_order_relaxed) - m_stats_base_head.load(std::memory_order_relaxed),
+			m_rejected.load(std::memory_order_relaxed),
+			m_wakeups.load(std::memory_order_relaxed),
+			m_latency.summary(),
+		};
+	}
+
+	void reset_stats() noexcept {
+		m_max_depth.store(depth(), std::memory_order_relaxed);
+		m_stats_base_tail.store(m_tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		m_stats_base_head.store(m_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		m_rejected.store(0, std::memory_order_relaxed);
+		m_wakeups.store(0, std::memory_order_relaxed);
+		m_latency.reset();
+	}
+
+private:
+	struct cell {
+		std::atomic<size_t> sequence;
+		main_thread_command command;
+	};
+
+	std::unique_ptr<cell[]> m_cells = std::make_unique<cell[]>(Capacity);
+	alignas(64) std::atomic<size_t> m_tail{ 0 };
+	alignas(64) std::atomic<size_t> m_head{ 0 };
+	std::atomic<bool> m_wake_pending{ false };
+	std::atomic<uint64_t> m_burst_start{ 0 };
+	std::atomic<size_t> m_max_depth{ 0 };
+	/* posted and executed are counted by tail and head, reset_stats moves the base */
+	std::atomic<size_t> m_stats_base_tail{ 0 };
+	std::atomic<size_t> m_stats_base_head{ 0 };
+	std::atomic<uint64_t> m_rejected{ 0 };
+	std::atomic<uint64_t> m_wakeups{ 0 };
+	latency_histogram m_latency;
+};
+
+namespace detail {
+using main_thread_queue_t = command_queue<GLFWHPP_COMMAND_QUEUE_CAPACITY>;
+
+/* created by the first use, until then polling skips the drain */
+inline std::atomic<main_thread_queue_t*> main_thread_queue_instance{ nullptr };
+
+inline main_thread_queue_t& main_thread_queue() {
+	static main_thread_queue_t queue;
+	[[maybe_unused]] static bool published = (main_thread_queue_instance.store(&queue, std::memory_order_release), true);
+	return queue;
+}
+}
+
+/* Window operations that have to run on the main thread, posted from any thread and run by the next poll_events / wait_events:
+ *	glfw::main_thread::post([window, title = std::string{ "..." }] { glfwSetWindowTitle(window, title.c_str()); }); */
+namespace main_thread {
+template<class Command>
+inline bool post(Command&& command) { return detail::main_thread_queue().post(std::forward<Command>(command)); }
+
+inline command_queue_stats stats() { return detail::main_thread_queue().stats(); }
+
+inline void reset_stats() { detail::main_thread_queue().reset_stats(); }
+}
+
+/************************************************************************************
+ *																					*
+ *								EVENTS & CALLBACKS									*
+ *																					*
+ ************************************************************************************/
+
+enum class monitor_event_type : int {
+	Connected = GLFW_CONNECTED,
+	Disconnected = GLFW_DISCONNECTED,
+};
+
+struct monitor_event {
+	monitor monitorObject;
+	monitor_event_type monitorStatus;
+};
+
+enum class error_type : int {
+	NoError = GLFW_NO_ERROR,
+	NotInitialized = GLFW_NOT_INITIALIZED,
+	NoCurrentContext = GLFW_NO_CURRENT_CONTEXT,
+	InvalidEnum = GLFW_INVALID_ENUM,
+	InvalidValue = GLFW_INVALID_VALUE,
+	OutOfMemory = GLFW_OUT_OF_MEMORY,
+	API_Unavailable = GLFW_API_UNAVAILABLE,
+	VersionUnavailable = GLFW_VERSION_UNAVAILABLE,
+	PlatformError = GLFW_PLATFORM_ERROR,
+	FormatUnavailable = GLFW_FORMAT_UNAVAILABLE,
+	NoWindowContext = GLFW_NO_WINDOW_CONTEXT,
+};
+
+struct error {
+	error_type errorType;
+	std::string_view description;
+};
+
+
+enum class key : int {
+	SPACE = GLFW_KEY_SPACE,
+	APOSTROPHE = GLFW_KEY_APOSTROPHE,
+	COMMA = GLFW_KEY_COMMA,
+	MINUS = GLFW_KEY_MINUS,
+	PERIOD = GLFW_KEY_PERIOD,
+	SLASH = GLFW_KEY_SLASH,
+	K0 = GLFW_KEY_0,
+	K1 = GLFW_KEY_1,
+	K2 = GLFW_KEY_2,
+	K3 = GLFW_KEY_3,
+	K4 = GLFW_KEY_4,
+	K5 = GLFW_KEY_5,
+	K6 = GLFW_KEY_6,
+	K7 = GLFW_KEY_7,
+	K8 = GLFW_KEY_8,
 	K9 = GLFW_KEY_9,
 	SEMICOLON = GLFW_KEY_SEMICOLON,
 	EQUAL = GLFW_KEY_EQUAL,
@@ -1105,15 +2095,19 @@ enum modifier_flags : int {
 
 struct key_event {
 	window_ref window;
-	key key;
+	glfw::key key;
 	int scancode;
 	key_action action;
 	modifier_flags modifiers;
+	/* glfwGetTimerValue ticks, captured when GLFW reported the event */
+	uint64_t timestamp = 0;
 };
 
 struct char_event {
 	window_ref window;
 	code_point codepoint;
+	/* glfwGetTimerValue ticks, captured when GLFW reported the event */
+	uint64_t timestamp = 0;
 };
 
 struct cursor_position {
@@ -1123,11 +2117,15 @@ struct cursor_position {
 struct cursor_event {
 	window_ref window;
 	cursor_position pos;
+	/* glfwGetTimerValue ticks, captured when GLFW reported the event */
+	uint64_t timestamp = 0;
 };
 
 struct cursor_enter_event {
 	window_ref window;
 	bool entered;
+	/* glfwGetTimerValue ticks, captured when GLFW reported the event */
+	uint64_t timestamp = 0;
 };
 
 enum class mouse_button : int {
@@ -1154,6 +2152,8 @@ struct mouse_button_event {
 	mouse_button button;
 	mouse_button_action action;
 	modifier_flags modifiers;
+	/* glfwGetTimerValue ticks, captured when GLFW reported the event */
+	uint64_t timestamp = 0;
 };
 
 struct mouse_scroll_offset {
@@ -1163,6 +2163,103 @@ struct mouse_scroll_offset {
 struct mouse_scroll_event {
 	window_ref window;
 	mouse_scroll_offset scroll;
+	/* glfwGetTimerValue ticks, captured when GLFW reported the event */
+	uint64_t timestamp = 0;
+};
+
+/* PerPoll delivers a single cursor event with the latest position, or a single scroll event
+ * with the summed offset, at the end of each poll_events / wait_events call */
+enum class coalesce_policy : uint8_t {
+	None,
+	PerPoll,
+};
+
+/* Raw samples folded into one coalesced cursor or scroll event, timestamps are raw timer ticks (see time_raw) */
+struct coalesced_samples {
+	uint32_t count;
+	uint64_t firstTimestamp;
+	uint64_t lastTimestamp;
+};
+
+/* Key and mouse button state of a window, kept up to date by its trampolines.
+ * Besides the current state it collects the presses and releases of the current frame, a frame ends with every
+ * poll_events/wait_events. A press and release within the same poll reports both, so short taps are not lost. */
+class input_state {
+public:
+	static constexpr size_t key_words = (GLFW_KEY_LAST + 64) / 64;
+	using key_bits = std::array<uint64_t, key_words>;
+	using button_bits = uint32_t;
+
+	bool is_down(key key) const { return test(m_keys, key); }
+	bool was_pressed_this_frame(key key) const { return test(m_pressedKeys, key); }
+	bool was_released_this_frame(key key) const { return test(m_releasedKeys, key); }
+
+	bool is_down(mouse_button button) const { return m_buttons & bit(button); }
+	bool was_pressed_this_frame(mouse_button button) const { return m_pressedButtons & bit(button); }
+	bool was_released_this_frame(mouse_button button) const { return m_releasedButtons & bit(button); }
+
+	key_bits const& pressed_keys() const { return m_pressedKeys; }
+	key_bits const& released_keys() const { return m_releasedKeys; }
+	/* fixed trip count so the loop vectorizes */
+	bool any_key_changed() const {
+		uint64_t changed = 0;
+		for (size_t i = 0; i < key_words; ++i) changed |= m_pressedKeys[i] | m_releasedKeys[i];
+		return changed != 0;
+	}
+	button_bits pressed_buttons() const { return m_pressedButtons; }
+	button_bits released_buttons() const { return m_releasedButtons; }
+
+	key_bits const& keys() const { return m_keys; }
+	button_bits buttons() const { return m_buttons; }
+
+	/* only transitions count, key repeats of a held key are ignored */
+	void set(key key, bool down) {
+		auto index = static_cast<int>(key);
+		if (index < 0 || index > GLFW_KEY_LAST) return; //GLFW_KEY_UNKNOWN
+		auto mask = uint64_t{ 1 } << (index % 64);
+		auto& word = m_keys[index / 64];
+		if (down == ((word & mask) != 0)) return;
+		if (down) {
+			word |= mask;
+			m_pressedKeys[index / 64] |= mask;
+		}
+		else {
+			word &= ~mask;
+			m_releasedKeys[index / 64] |= mask;
+		}
+	}
+	void set(mouse_button button, bool down) {
+		if (down == ((m_buttons & bit(button)) != 0)) return;
+		if (down) {
+			m_buttons |= bit(button);
+			m_pressedButtons |= bit(button);
+		}
+		else {
+			m_buttons &= ~bit(button);
+			m_releasedButtons |= bit(button);
+		}
+	}
+	void next_frame() {
+		m_pressedKeys = {};
+		m_releasedKeys = {};
+		m_pressedButtons = 0;
+		m_releasedButtons = 0;
+	}
+	void clear() { *this = input_state{}; }
+
+private:
+	static bool test(key_bits const& bits, key key) {
+		auto index = static_cast<int>(key);
+		return index >= 0 && index <= GLFW_KEY_LAST && (bits[index / 64] >> (index % 64)) & 1;
+	}
+	static button_bits bit(mouse_button button) { return button_bits{ 1 } << static_cast<int>(button); }
+
+	key_bits m_keys = {};
+	key_bits m_pressedKeys = {};
+	key_bits m_releasedKeys = {};
+	button_bits m_buttons = 0;
+	button_bits m_pressedButtons = 0;
+	button_bits m_releasedButtons = 0;
 };
 
 enum class joystick_id : int {
@@ -1232,6 +2329,8 @@ enum class joystick_state : int {
 struct joystick_event {
 	joystick_id joystick;
 	joystick_state state;
+	/* glfwGetTimerValue ticks, captured when GLFW reported the event */
+	uint64_t timestamp = 0;
 };
 
 enum class gamepad_button : size_t {
@@ -1265,151 +2364,922 @@ enum class gamepad_axis : size_t {
 	RightTrigger = GLFW_GAMEPAD_AXIS_RIGHT_TRIGGER,
 };
 
-struct drop_event {
-	window_ref window;
-	std::vector<std::string_view> paths;
-};
+/* Non-owning view over the path list GLFW passes to the drop callback, string_views are only created on access.
+ * The paths are valid for the duration of the drop callback, or until the next poll for buffered events. */
+class drop_paths {
+public:
+	class iterator {
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = std::string_view;
+
+		explicit iterator(char const* const* path) : m_path(path) {}
+
+		std::string_view operator*() const { return std::string_view{ *m_path }; }
+		iterator& operator++() { ++m_path; return *this; }
+		iterator operator++(int) { auto it = *this; ++m_path; return it; }
+		bool operator==(iterator const& rhs) const { return m_path == rhs.m_path; }
+		bool operator!=(iterator const& rhs) const { return m_path != rhs.m_path; }
+	private:
+		char const* const* m_path;
+	};
 
+	drop_paths() = default;
+	drop_paths(char const* const* paths, size_t count) : m_paths(paths), m_count(count) {}
 
-namespace detail {
+	iterator begin() const { return iterator{ m_paths }; }
+	iterator end() const { return iterator{ m_paths + m_count }; }
+	size_t size() const { return m_count; }
+	bool empty() const { return m_count == 0; }
+	std::string_view operator[](size_t index) const { return std::string_view{ m_paths[index] }; }
+	char const* const* data() const { return m_paths; }
 
-struct window_callback {
-	std::function<void(window_ref)> callback;
-	uint16_t mask;
+private:
+	char const* const* m_paths = nullptr;
+	size_t m_count = 0;
 };
 
-namespace callbacks {
-
-struct window_callbacks {
-	window_callback window_callback;
-	std::function<void(key_event)> key_callback;
-	std::function<void(char_event)> char_callback;
-	std::function<void(cursor_event)> cursor_callback;
-	std::function<void(cursor_enter_event)> cursor_enter_callback;
-	std::function<void(mouse_button_event)> mouse_button_callback;
-	std::function<void(mouse_scroll_event)> mouse_scroll_callback;
-	std::function<void(drop_event)> drop_callback;
+struct drop_event {
+	window_ref window;
+	drop_paths paths;
+	/* glfwGetTimerValue ticks, captured when GLFW reported the event */
+	uint64_t timestamp = 0;
 };
 
-inline static std::function<void(error)> error_callback;
-inline static std::function<void(monitor_event)> monitor_callback;
-inline static std::unordered_map<GLFWWindow*, window_callbacks> window_callbacks;
-inline static std::function<void(joystick_event)> joystick_callback;
+struct window_event {
+	window_ref window;
+	window_event_type type;
+	/* glfwGetTimerValue ticks, captured when GLFW reported the event */
+	uint64_t timestamp = 0;
+};
 
+enum class event_type : uint8_t {
+	Key,
+	Char,
+	Cursor,
+	CursorEnter,
+	MouseButton,
+	MouseScroll,
+	Drop,
+	Window,
+	Joystick,
+};
 
+/* Compact tagged event record collected in buffered mode, see buffered_events.
+ * Trivially copyable and at most 32 bytes, so events can live in flat arrays, be memcpy'd and passed between threads.
+ * The source window is stored as its callback slot, glfw::visit turns the record back into the typed event structs.
+ * Drop paths point into storage of the event queue and share the lifetime of the batch. */
+struct event {
+	struct key_data {
+		int32_t key;
+		int32_t scancode;
+		uint8_t action;
+		uint8_t modifiers;
+	};
+	struct char_data {
+		uint32_t codepoint;
+	};
+	struct cursor_enter_data {
+		bool entered;
+	};
+	struct mouse_button_data {
+		uint8_t button;
+		uint8_t action;
+		uint8_t modifiers;
+	};
+	struct drop_data {
+		char const* const* paths;
+		uint32_t count;
+	};
+	struct window_data {
+		window_event_type type;
+		union {
+			window_position position;
+			window_size size;
+			framebuffer_size framebuffer;
+			window_content_scale scale;
+			bool state; /* focus, minimize and maximize state */
+		};
+	};
+	struct joystick_data {
+		uint8_t id;
+		bool connected;
+	};
 
-inline void glfw_monitor_callback(GLFWmonitor* glfwMonitor, int eventType) {
-	monitor_callback(monitor_event{ monitor{ glfwMonitor }, monitor_event_type{eventType} });
-}
+	/* window_id of joystick events, never given to a window */
+	static constexpr uint32_t no_window = UINT32_MAX;
+
+	event_type type;
+	/* low 12 bits: callback slot, high 20 bits: generation of the slot, so ids of destroyed windows stop resolving
+	 * until their slot has been reused 2^20 times */
+	uint32_t window_id;
+	/* glfwGetTimerValue ticks, captured on entry of the trampoline */
+	uint64_t timestamp;
+	union {
+		key_data key;
+		char_data character;
+		cursor_position cursor;
+		cursor_enter_data cursor_enter;
+		mouse_button_data mouse_button;
+		mouse_scroll_offset scroll;
+		drop_data drop;
+		window_data window;
+		joystick_data joystick;
+	};
 
-inline void glfw_error_callback(int error, char const* description) {
-	error_callback(glfw::error{ error_type{ error }, std::string_view{ description } });
+	/* source window, null for joystick events and windows destroyed since the event, even if their slot was reused
+	 * (up to 2^20 times, see window_id) */
+	inline GLFWwindow* source() const;
+};
+static_assert(sizeof(event) <= 32, "glfw::event has to stay compact");
+static_assert(std::is_trivially_copyable_v<event>, "glfw::event has to stay trivially copyable");
+
+/* Calls the visitor with the typed event struct matching the record */
+template<class Visitor>
+decltype(auto) visit(Visitor&& visitor, event const& e) {
+	auto window = window_ref{ e.source() };
+	switch (e.type) {
+	case event_type::Key:
+		return std::invoke(std::forward<Visitor>(visitor), key_event{ window, glfw::key{ e.key.key }, e.key.scancode, key_action{ e.key.action }, modifier_flags{ e.key.modifiers }, e.timestamp });
+	case event_type::Char:
+		return std::invoke(std::forward<Visitor>(visitor), char_event{ window, code_point{ e.character.codepoint }, e.timestamp });
+	case event_type::Cursor:
+		return std::invoke(std::forward<Visitor>(visitor), cursor_event{ window, e.cursor, e.timestamp });
+	case event_type::CursorEnter:
+		return std::invoke(std::forward<Visitor>(visitor), cursor_enter_event{ window, e.cursor_enter.entered, e.timestamp });
+	case event_type::MouseButton:
+		return std::invoke(std::forward<Visitor>(visitor), mouse_button_event{ window, mouse_button{ e.mouse_button.button }, mouse_button_action{ e.mouse_button.action }, modifier_flags{ e.mouse_button.modifiers }, e.timestamp });
+	case event_type::MouseScroll:
+		return std::invoke(std::forward<Visitor>(visitor), mouse_scroll_event{ window, e.scroll, e.timestamp });
+	case event_type::Drop:
+		return std::invoke(std::forward<Visitor>(visitor), drop_event{ window, drop_paths{ e.drop.paths, e.drop.count }, e.timestamp });
+	case event_type::Window:
+		return std::invoke(std::forward<Visitor>(visitor), window_event{ window, e.window.type, e.timestamp });
+	case event_type::Joystick:
+	default:
+		return std::invoke(std::forward<Visitor>(visitor), joystick_event{ joystick_id{ e.joystick.id }, e.joystick.connected ? joystick_state::Connected : joystick_state::Disconnected, e.timestamp });
+	}
 }
 
+class event_batch;
 
+namespace detail {
 
-inline void glfw_window_pos_callback(GLFWwindow* sourceWindow, int, int) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.window_callback.mask & POSITION_CHANGED && cb->second.window_callback.callback) cb->second.window_callback.callback(window_ref{ sourceWindow });
-}
+/* Per-thread ring buffer filled by the callback trampolines of buffered windows.
+ * Indices grow monotonically, the ring doubles its capacity when full. */
+class event_queue {
+public:
+	template<class Event>
+	void push(Event&& event) {
+		if (m_tail - m_head == m_events.size()) grow();
+		m_events[m_tail++ & (m_events.size() - 1)] = std::forward<Event>(event);
+	}
 
-inline void glfw_window_size_callback(GLFWwindow* sourceWindow, int, int) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.window_callback.mask & SIZE_CHANGED && cb->second.window_callback.callback) cb->second.window_callback.callback(window_ref{ sourceWindow });
-}
+	/* constructs the record returned by make straight in its slot: a record assembled field by field in a stack
+	 * temporary and then copied stalls on store forwarding */
+	template<class Make>
+	void emplace(Make&& make) {
+		if (m_tail - m_head == m_events.size()) grow();
+		::new (static_cast<void*>(&m_events[m_tail++ & (m_events.size() - 1)])) event(make());
+	}
 
-inline void glfw_framebuffer_size_callback(GLFWwindow* sourceWindow, int, int) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.window_callback.mask & FRAMEBUFFER_SIZE_CHANGED && cb->second.window_callback.callback) cb->second.window_callback.callback(window_ref{ sourceWindow });
-}
+	/* copies the paths of the drop event pushed next, they stay valid until its batch is discarded */
+	char const* const* store_paths(int count, char const** paths) {
+		size_t textSize = 0;
+		for (int i = 0; i < count; ++i) textSize += std::strlen(paths[i]) + 1;
 
-inline void glfw_window_content_scale_callback(GLFWwindow* sourceWindow, float, float) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.window_callback.mask & CONTENT_SCALE_CHANGED && cb->second.window_callback.callback) cb->second.window_callback.callback(window_ref{ sourceWindow });
-}
+		auto& storage = m_paths.emplace_back(drop_storage{ m_tail, std::make_unique<char const*[]>(count), std::make_unique<char[]>(textSize) });
+		char* text = storage.text.get();
+		for (int i = 0; i < count; ++i) {
+			size_t length = std::strlen(paths[i]) + 1;
+			std::memcpy(text, paths[i], length);
+			storage.paths[i] = text;
+			text += length;
+		}
+		return storage.paths.get();
+	}
 
-inline void glfw_window_focus_callback(GLFWwindow* sourceWindow, int) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.window_callback.mask & FOCUS_CHANGED && cb->second.window_callback.callback) cb->second.window_callback.callback(window_ref{ sourceWindow });
-}
+	/* discards the events of the last batch and the paths of its drops */
+	void begin_batch() {
+		m_head = m_batchEnd;
+		//paths are stored in event order, events pushed after the last batch keep theirs
+		auto kept = std::find_if(m_paths.begin(), m_paths.end(), [this](drop_storage const& storage) { return storage.event >= m_head; });
+		m_paths.erase(m_paths.begin(), kept);
+	}
 
-inline void glfw_window_minimize_callback(GLFWwindow* sourceWindow, int) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.window_callback.mask & MINIMIZE_STATE_CHANGED && cb->second.window_callback.callback) cb->second.window_callback.callback(window_ref{ sourceWindow });
-}
+	inline event_batch end_batch();
 
-inline void glfw_window_maximize_callback(GLFWwindow* sourceWindow, int) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.window_callback.mask & MAXIMIZE_STATE_CHANGED && cb->second.window_callback.callback) cb->second.window_callback.callback(window_ref{ sourceWindow });
-}
+	event const& operator[](size_t index) const { return m_events[index & (m_events.size() - 1)]; }
 
-inline void glfw_window_refresh_callback(GLFWwindow* sourceWindow) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.window_callback.mask & CONTENT_NEEDS_REFRESH && cb->second.window_callback.callback) cb->second.window_callback.callback(window_ref{ sourceWindow });
-}
-inline void glfw_window_close_callback(GLFWwindow* sourceWindow) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.window_callback.mask & CLOSE_REQUESTED && cb->second.window_callback.callback) cb->second.window_callback.callback(window_ref{ sourceWindow });
-}
+private:
+	struct drop_storage {
+		/* index of the drop event */
+		size_t event;
+		std::unique_ptr<char const*[]> paths;
+		std::unique_ptr<char[]> text;
+	};
 
-inline void glfw_drop_callback(GLFWwindow* sourceWindow, int count, char const** paths) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.drop_callback) {
-		drop_event dropEvent{ window_ref{sourceWindow} };
-		dropEvent.paths.reserve(count);
-		for (size_t i = 0; i < count; ++i) {
-			dropEvent.paths.emplace_back(paths[i]);
+	void grow() {
+		auto events = std::vector<event>(m_events.empty() ? 256 : m_events.size() * 2);
+		for (size_t i = m_head; i != m_tail; ++i) {
+			events[i & (events.size() - 1)] = m_events[i & (m_events.size() - 1)];
 		}
-		cb->second.drop_callback(std::move(dropEvent));
+		m_events = std::move(events);
 	}
-}
 
+	std::vector<event> m_events;
+	std::vector<drop_storage> m_paths;
+	size_t m_head = 0;
+	size_t m_tail = 0;
+	size_t m_batchEnd = 0;
+};
 
-inline void glfw_key_callback(GLFWwindow* sourceWindow, int key, int scanCode, int action, int modifiers) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.key_callback) cb->second.key_callback(key_event{ window_ref{sourceWindow}, glfw::key{key}, scanCode, key_action{action}, modifier_flags{modifiers} });
+inline thread_local event_queue thread_events;
 }
 
-inline void glfw_char_callback(GLFWwindow* sourceWindow, uint32_t codepoint) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.char_callback) cb->second.char_callback(char_event{ window_ref{sourceWindow}, code_point{codepoint} });
-}
+/* Events collected by one poll_events / wait_events call.
+ * A batch stays valid until the next poll_events / wait_events call on the same thread. */
+class event_batch {
+public:
+	class iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = event;
+		using difference_type = std::ptrdiff_t;
+		using pointer = event const*;
+		using reference = event const&;
+
+		iterator(detail::event_queue const* queue, size_t index) : m_queue(queue), m_index(index) {}
+
+		reference operator*() const { return (*m_queue)[m_index]; }
+		pointer operator->() const { return &(*m_queue)[m_index]; }
+		iterator& operator++() { ++m_index; return *this; }
+		iterator operator++(int) { auto it = *this; ++m_index; return it; }
+		bool operator==(iterator const& rhs) const { return m_index == rhs.m_index; }
+		bool operator!=(iterator const& rhs) const { return m_index != rhs.m_index; }
+	private:
+		detail::event_queue const* m_queue;
+		size_t m_index;
+	};
 
-inline void glfw_cursor_callback(GLFWwindow* sourceWindow, double xpos, double ypos) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.cursor_callback) cb->second.cursor_callback(cursor_event{ window_ref{sourceWindow}, cursor_position{xpos,ypos} });
-}
+	event_batch() = default;
+	event_batch(detail::event_queue const* queue, size_t first, size_t last) : m_queue(queue), m_first(first), m_last(last) {}
 
-inline void glfw_cursor_enter_callback(GLFWwindow* sourceWindow, int entered) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.cursor_enter_callback) cb->second.cursor_enter_callback(cursor_enter_event{ window_ref{sourceWindow}, entered == GLFW_TRUE });
-}
+	iterator begin() const { return iterator{ m_queue, m_first }; }
+	iterator end() const { return iterator{ m_queue, m_last }; }
+	size_t size() const { return m_last - m_first; }
+	bool empty() const { return m_first == m_last; }
+	event const& operator[](size_t index) const { return (*m_queue)[m_first + index]; }
 
-inline void glfw_mouse_button_callback(GLFWwindow* sourceWindow, int button, int action, int mods) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.mouse_button_callback) cb->second.mouse_button_callback(mouse_button_event{ window_ref{sourceWindow}, mouse_button{button}, mouse_button_action{action}, modifier_flags{mods} });
-}
+private:
+	detail::event_queue const* m_queue = nullptr;
+	size_t m_first = 0;
+	size_t m_last = 0;
+};
 
-inline void glfw_mouse_scroll_callback(GLFWwindow* sourceWindow, double xOffset, double yOffset) {
-	if (auto cb = window_callbacks.find(sourceWindow); cb != window_callbacks.end() && cb->second.mouse_scroll_callback) cb->second.mouse_scroll_callback(mouse_scroll_event{ window_ref{sourceWindow}, mouse_scroll_offset{xOffset, yOffset} });
+inline event_batch detail::event_queue::end_batch() {
+	m_batchEnd = m_tail;
+	return event_batch{ this, m_head, m_tail };
 }
 
 
+namespace detail {
 
-inline void glfw_joystick_callback(int id, int event) {
-	if (joystick_callback) joystick_callback(joystick_event{ joystick_id{id}, joystick_state{event} });
-}
-}
-}
+struct window_callback {
+	inplace_function<void(window_ref)> callback;
+	uint16_t mask;
+};
 
-enum class key_input_mode : int {
-	StickyKeys,
-	LockKeyModifiers,
+namespace callbacks {
+
+struct cached_window_state {
+	bool focused;
+	bool minimized;
+	bool maximized;
+	bool hovered;
+	bool visible;
 };
 
-enum class cursor_input_mode : int {
-	Normal = GLFW_CURSOR_NORMAL,
-	Disabled = GLFW_CURSOR_DISABLED,
-	Hidden = GLFW_CURSOR_HIDDEN,
+/* GLFW callback slots of a window, the window events use their window_event_type bit */
+enum trampoline_slot : uint32_t {
+	KEY_TRAMPOLINE = 1 << 16,
+	CHAR_TRAMPOLINE = 1 << 17,
+	CURSOR_TRAMPOLINE = 1 << 18,
+	CURSOR_ENTER_TRAMPOLINE = 1 << 19,
+	MOUSE_BUTTON_TRAMPOLINE = 1 << 20,
+	SCROLL_TRAMPOLINE = 1 << 21,
+	DROP_TRAMPOLINE = 1 << 22,
 };
 
-namespace detail {
-//internal gamepad mappings
-inline static std::array<GLFWgamepadstate, GLFW_JOYSTICK_LAST> gamepad_states;
-}
+#ifdef GLFWHPP_COROUTINES
+/* coroutine suspended on a window's input, see async::next_key */
+template<class Event>
+struct event_waiter {
+	event_waiter* next;
+	std::coroutine_handle<> handle;
+	std::optional<Event> event;
+};
+#endif
 
-enum class gamepad_button_state : unsigned char {
-	Pressed = GLFW_PRESS,
-	Released = GLFW_RELEASE,
+/* Per-window callback block. It is reachable through the GLFW window user pointer, so
+ * dispatching an event costs a single pointer load instead of a hash lookup.
+ * The typed user pointer of the window api is stored here as well. */
+struct window_callbacks {
+	detail::window_callback window_callback;
+	inplace_function<void(key_event)> key_callback;
+	inplace_function<void(char_event)> char_callback;
+	inplace_function<void(cursor_event)> cursor_callback;
+	inplace_function<void(cursor_enter_event)> cursor_enter_callback;
+	inplace_function<void(mouse_button_event)> mouse_button_callback;
+	inplace_function<void(mouse_scroll_event)> mouse_scroll_callback;
+	inplace_function<void(drop_event)> drop_callback;
+
+	void* user_pointer = nullptr;
+	GLFWwindow* handle = nullptr;
+	/* created by glfw::window, which releases the block before destroying the window. Blocks of raw handles are only
+	 * released by destroy_window / release_window, slot table walks must not pass their handle to GLFW */
+	bool owned = false;
+	uint16_t slot = 0;
+	/* event::window_id, slot and generation */
+	uint32_t id = 0;
+	bool buffered = false;
+
+	/* static handler, see glfw::handler */
+	void* handler = nullptr;
+	uint32_t handler_slots = 0;
+
+	coalesce_policy cursor_policy = coalesce_policy::None;
+	coalesce_policy scroll_policy = coalesce_policy::None;
+	bool coalesce_pending = false;
+	cursor_position pending_cursor{};
+	mouse_scroll_offset pending_scroll{};
+	coalesced_samples pending_cursor_samples{};
+	coalesced_samples pending_scroll_samples{};
+	coalesced_samples cursor_samples{};
+	coalesced_samples scroll_samples{};
+
+	/* mirrored window state, see cached_state */
+	std::optional<cached_window_state> state_cache;
+	/* mirrored window geometry, see cached_geometry */
+	std::optional<window_geometry> geometry_cache;
+
+	/* tracked key and mouse button state, see input::enable_input_state */
+	std::unique_ptr<input_state> input;
+
+	/* see render_threads::start */
+	std::unique_ptr<render_thread> render;
+
+	/* set while async::next_key / next_mouse_button wait on the window, keeps their trampolines installed */
+	bool awaited = false;
+#ifdef GLFWHPP_COROUTINES
+	event_waiter<key_event>* key_waiters = nullptr;
+	event_waiter<mouse_button_event>* mouse_button_waiters = nullptr;
+#endif
+
+#ifdef GLFWHPP_INSTRUMENTATION
+	window_metrics metrics;
+#endif
 };
 
-struct gamepad_state {
-	struct gamepad_buttons {
+inline inplace_function<void(error)> error_callback;
+inline inplace_function<void(monitor_event)> monitor_callback;
+inline inplace_function<void(joystick_event)> joystick_callback;
+inline bool buffer_joystick_events = false;
+
+/* windows holding coalesced input that is delivered after the current poll, and the list flush_coalesced is walking;
+ * release() clears a destroyed window from both */
+inline thread_local std::vector<window_callbacks*> coalesced_windows;
+inline thread_local std::vector<window_callbacks*> flushing_windows;
+
+/* Dense slot table owning the callback blocks, freed slots are reused with the next generation */
+inline std::vector<std::unique_ptr<window_callbacks>> window_slots;
+inline std::vector<uint32_t> window_slot_generations;
+inline std::vector<uint16_t> free_window_slots;
+
+inline constexpr uint32_t WINDOW_SLOT_BITS = 12;
+inline constexpr uint32_t WINDOW_SLOT_MASK = (1u << WINDOW_SLOT_BITS) - 1;
+inline constexpr uint32_t WINDOW_GENERATION_MASK = (1u << (32 - WINDOW_SLOT_BITS)) - 1;
+
+/* Every event entering the trampolines passes through record, see input_recorder.
+ * recording_input makes update_trampolines install all trampolines of a window. */
+#ifdef GLFWHPP_RECORD_REPLAY
+inline bool recording_input = false;
+inline void record(event const& e, char const* const* paths = nullptr);
+#else
+inline constexpr bool recording_input = false;
+inline void record(event const&, char const* const* = nullptr) {}
+#endif
+
+inline void update_trampolines(GLFWwindow* window);
+
+inline window_callbacks* find(GLFWwindow* window) {
+	return static_cast<window_callbacks*>(glfwGetWindowUserPointer(window));
+}
+
+inline window_callbacks& acquire(GLFWwindow* window) {
+	if (auto cb = find(window)) return *cb;
+
+	uint16_t slot;
+	if (!free_window_slots.empty()) {
+		slot = free_window_slots.back();
+		free_window_slots.pop_back();
+	}
+	else {
+		//the last slot stays unused, its last generation would be event::no_window
+		if (window_slots.size() >= WINDOW_SLOT_MASK) throw std::length_error("Too many GLFW windows");
+		slot = static_cast<uint16_t>(window_slots.size());
+		window_slots.emplace_back();
+		window_slot_generations.push_back(0);
+	}
+	window_slots[slot] = std::make_unique<window_callbacks>();
+	window_slots[slot]->handle = window;
+	window_slots[slot]->slot = slot;
+	window_slots[slot]->id = slot | (window_slot_generations[slot] << WINDOW_SLOT_BITS);
+	glfwSetWindowUserPointer(window, window_slots[slot].get());
+	//windows appearing while a recording runs are recorded from their first event
+	if (recording_input) update_trampolines(window);
+	return *window_slots[slot];
+}
+
+inline void acquire_owned(GLFWwindow* window) { acquire(window).owned = true; }
+
+/* current window of a slot, ignoring the generation */
+inline GLFWwindow* window_from_slot(uint16_t slot) {
+	return slot < window_slots.size() && window_slots[slot] ? window_slots[slot]->handle : nullptr;
+}
+
+/* window of an event::window_id, null once the window was destroyed even if its slot is reused (modulo 2^20 reuses) */
+inline GLFWwindow* window_from_id(uint32_t windowId) {
+	uint32_t slot = windowId & WINDOW_SLOT_MASK;
+	return slot < window_slots.size() && window_slots[slot] && window_slots[slot]->id == windowId ? window_slots[slot]->handle : nullptr;
+}
+
+#ifdef GLFWHPP_COROUTINES
+/* resumes the waiters in the order they suspended, coroutines awaiting again wait for the next event */
+template<class Event>
+inline void resume_waiters(event_waiter<Event>*& waiters, Event const& e) {
+	event_waiter<Event>* ordered = nullptr;
+	for (auto waiter = std::exchange(waiters, nullptr); waiter;) {
+		auto next = waiter->next;
+		waiter->next = ordered;
+		ordered = waiter;
+		waiter = next;
+	}
+	while (ordered) {
+		auto next = ordered->next;
+		ordered->event = e;
+		ordered->handle.resume();
+		ordered = next;
+	}
+}
+
+/* tasks still waiting on a destroyed window never resume, their frames are freed */
+template<class Event>
+inline void destroy_waiters(event_waiter<Event>*& waiters) {
+	for (auto waiter = std::exchange(waiters, nullptr); waiter;) {
+		auto next = waiter->next;
+		waiter->handle.destroy();
+		waiter = next;
+	}
+}
+
+/* called after resuming waiters, once no task awaits input of the window its trampolines are only kept for callbacks */
+inline void settle_awaited(GLFWwindow* window) {
+	//re-read the block, a resumed task may have released it
+	auto cb = find(window);
+	if (cb && cb->awaited && !cb->key_waiters && !cb->mouse_button_waiters) {
+		cb->awaited = false;
+		update_trampolines(window);
+	}
+}
+#endif
+
+inline void release(GLFWwindow* window) {
+	if (!window) return;
+	if (auto cb = find(window)) {
+		cb->render.reset();
+#ifdef GLFWHPP_COROUTINES
+		destroy_waiters(cb->key_waiters);
+		destroy_waiters(cb->mouse_button_waiters);
+#endif
+		coalesced_windows.erase(std::remove(coalesced_windows.begin(), coalesced_windows.end(), cb), coalesced_windows.end());
+		std::replace(flushing_windows.begin(), flushing_windows.end(), cb, static_cast<window_callbacks*>(nullptr));
+		uint16_t slot = cb->slot;
+		glfwSetWindowUserPointer(window, nullptr);
+		window_slots[slot].reset();
+		window_slot_generations[slot] = (window_slot_generations[slot] + 1) & WINDOW_GENERATION_MASK;
+		free_window_slots.push_back(slot);
+	}
+}
+
+inline void* get_user_pointer(GLFWwindow* window) {
+	auto cb = find(window);
+	return cb ? cb->user_pointer : nullptr;
+}
+
+inline void set_user_pointer(GLFWwindow* window, void* userPointer) {
+	acquire(window).user_pointer = userPointer;
+}
+
+
+inline void glfw_monitor_callback(GLFWmonitor* glfwMonitor, int eventType) {
+	if (monitor_registry.enabled) refresh_monitor_registry();
+	if (monitor_callback) monitor_callback(monitor_event{ monitor{ glfwMonitor }, monitor_event_type{eventType} });
+}
+
+inline void glfw_error_callback(int error, char const* description) {
+	if (error_callback) error_callback(glfw::error{ error_type{ error }, std::string_view{ description } });
+}
+
+/* typed event -> compact record */
+inline event make_event(uint32_t windowId, event_type type, uint64_t timestamp) {
+	event result{};
+	result.type = type;
+	result.window_id = windowId;
+	result.timestamp = timestamp;
+	return result;
+}
+
+inline event make_event(uint32_t windowId, key_event const& e) {
+	auto result = make_event(windowId, event_type::Key, e.timestamp);
+	result.key = { static_cast<int32_t>(e.key), e.scancode, static_cast<uint8_t>(e.action), static_cast<uint8_t>(e.modifiers) };
+	return result;
+}
+
+inline event make_event(uint32_t windowId, char_event const& e) {
+	auto result = make_event(windowId, event_type::Char, e.timestamp);
+	result.character = { static_cast<uint32_t>(e.codepoint) };
+	return result;
+}
+
+inline event make_event(uint32_t windowId, cursor_event const& e) {
+	auto result = make_event(windowId, event_type::Cursor, e.timestamp);
+	result.cursor = e.pos;
+	return result;
+}
+
+inline event make_event(uint32_t windowId, cursor_enter_event const& e) {
+	auto result = make_event(windowId, event_type::CursorEnter, e.timestamp);
+	result.cursor_enter = { e.entered };
+	return result;
+}
+
+inline event make_event(uint32_t windowId, mouse_button_event const& e) {
+	auto result = make_event(windowId, event_type::MouseButton, e.timestamp);
+	result.mouse_button = { static_cast<uint8_t>(e.button), static_cast<uint8_t>(e.action), static_cast<uint8_t>(e.modifiers) };
+	return result;
+}
+
+inline event make_event(uint32_t windowId, mouse_scroll_event const& e) {
+	auto result = make_event(windowId, event_type::MouseScroll, e.timestamp);
+	result.scroll = e.scroll;
+	return result;
+}
+
+/* hands the event to the thread event queue for buffered windows, to the user callback otherwise */
+template<class Callback, class Event>
+inline void deliver(window_callbacks& cb, Callback const& callback, Event&& e) {
+	if (cb.buffered) thread_events.emplace([&] { return make_event(cb.id, e); });
+	else if (callback) {
+#ifdef GLFWHPP_INSTRUMENTATION
+		scoped_sample sample{ cb.metrics.callback };
+#endif
+		callback(std::forward<Event>(e));
+	}
+}
+
+/* the frame has no callback of its own, its extents are re-read when size or content scale change */
+inline void update_geometry(GLFWwindow* window, window_geometry& geometry, event::window_data const& data) {
+	auto changed = [&](auto& cached, auto const& value) {
+		if (std::memcmp(&cached, &value, sizeof(value)) == 0) return;
+		cached = value;
+		++geometry.generation;
+	};
+	switch (data.type) {
+	case POSITION_CHANGED: changed(geometry.position, data.position); break;
+	case SIZE_CHANGED: changed(geometry.size, data.size); break;
+	case FRAMEBUFFER_SIZE_CHANGED: changed(geometry.framebuffer, data.framebuffer); break;
+	case CONTENT_SCALE_CHANGED: changed(geometry.scale, data.scale); break;
+	default: return;
+	}
+	if (data.type & (SIZE_CHANGED | CONTENT_SCALE_CHANGED)) {
+		window_frame frame;
+		glfwGetWindowFrameSize(window, &frame.left, &frame.top, &frame.right, &frame.bottom);
+		changed(geometry.frame, frame);
+	}
+}
+
+inline void dispatch_window_event(GLFWwindow* sourceWindow, event::window_data const& data) {
+	uint64_t timestamp = glfwGetTimerValue();
+	auto cb = find(sourceWindow);
+	if (!cb) return;
+	auto e = make_event(cb->id, event_type::Window, timestamp);
+	e.window = data;
+	record(e);
+	if (cb->state_cache) {
+		if (data.type == FOCUS_CHANGED) cb->state_cache->focused = data.state;
+		else if (data.type == MINIMIZE_STATE_CHANGED) cb->state_cache->minimized = data.state;
+		else if (data.type == MAXIMIZE_STATE_CHANGED) cb->state_cache->maximized = data.state;
+	}
+	if (cb->geometry_cache) update_geometry(sourceWindow, *cb->geometry_cache, data);
+	if (cb->buffered) thread_events.push(e);
+	else if (cb->window_callback.mask & data.type && cb->window_callback.callback) {
+#ifdef GLFWHPP_INSTRUMENTATION
+		scoped_sample sample{ cb->metrics.callback };
+#endif
+		cb->window_callback.callback(window_ref{ sourceWindow });
+	}
+}
+
+inline event::window_data window_data(window_event_type type) {
+	event::window_data data{};
+	data.type = type;
+	return data;
+}
+
+inline void glfw_window_pos_callback(GLFWwindow* sourceWindow, int x, int y) {
+	auto data = window_data(POSITION_CHANGED);
+	data.position = { x, y };
+	dispatch_window_event(sourceWindow, data);
+}
+
+inline void glfw_window_size_callback(GLFWwindow* sourceWindow, int width, int height) {
+	auto data = window_data(SIZE_CHANGED);
+	data.size = { width, height };
+	dispatch_window_event(sourceWindow, data);
+}
+
+inline void glfw_framebuffer_size_callback(GLFWwindow* sourceWindow, int width, int height) {
+	auto data = window_data(FRAMEBUFFER_SIZE_CHANGED);
+	data.framebuffer = { width, height };
+	dispatch_window_event(sourceWindow, data);
+}
+
+inline void glfw_window_content_scale_callback(GLFWwindow* sourceWindow, float xScale, float yScale) {
+	auto data = window_data(CONTENT_SCALE_CHANGED);
+	data.scale = { xScale, yScale };
+	dispatch_window_event(sourceWindow, data);
+}
+
+inline void glfw_window_focus_callback(GLFWwindow* sourceWindow, int focused) {
+	auto data = window_data(FOCUS_CHANGED);
+	data.state = focused == GLFW_TRUE;
+	dispatch_window_event(sourceWindow, data);
+}
+
+inline void glfw_window_minimize_callback(GLFWwindow* sourceWindow, int minimized) {
+	auto data = window_data(MINIMIZE_STATE_CHANGED);
+	data.state = minimized == GLFW_TRUE;
+	dispatch_window_event(sourceWindow, data);
+}
+
+inline void glfw_window_maximize_callback(GLFWwindow* sourceWindow, int maximized) {
+	auto data = window_data(MAXIMIZE_STATE_CHANGED);
+	data.state = maximized == GLFW_TRUE;
+	dispatch_window_event(sourceWindow, data);
+}
+
+inline void glfw_window_refresh_callback(GLFWwindow* sourceWindow) {
+	dispatch_window_event(sourceWindow, window_data(CONTENT_NEEDS_REFRESH));
+}
+
+inline void glfw_window_close_callback(GLFWwindow* sourceWindow) {
+	dispatch_window_event(sourceWindow, window_data(CLOSE_REQUESTED));
+}
+
+inline void flush_pending(window_callbacks& cb);
+
+inline void glfw_drop_callback(GLFWwindow* sourceWindow, int count, char const** paths) {
+	uint64_t timestamp = glfwGetTimerValue();
+	auto cb = find(sourceWindow);
+	if (!cb) return;
+	auto e = make_event(cb->id, event_type::Drop, timestamp);
+	e.drop = { nullptr, static_cast<uint32_t>(count) };
+	record(e, paths);
+	flush_pending(*cb);
+	if (cb->buffered) {
+		//GLFW releases the paths after the callback returns, buffered events need their own copy
+		e.drop.paths = thread_events.store_paths(count, paths);
+		thread_events.push(e);
+	}
+	else if (cb->drop_callback) {
+#ifdef GLFWHPP_INSTRUMENTATION
+		scoped_sample sample{ cb->metrics.callback };
+#endif
+		cb->drop_callback(drop_event{ window_ref{sourceWindow}, drop_paths{ paths, static_cast<size_t>(count) }, timestamp });
+	}
+}
+
+
+inline void glfw_key_callback(GLFWwindow* sourceWindow, int key, int scanCode, int action, int modifiers) {
+	uint64_t timestamp = glfwGetTimerValue();
+	auto cb = find(sourceWindow);
+	if (!cb) return;
+	key_event e{ window_ref{sourceWindow}, glfw::key{key}, scanCode, key_action{action}, modifier_flags{modifiers}, timestamp };
+	record(make_event(cb->id, e));
+	if (cb->input) cb->input->set(glfw::key{key}, action != GLFW_RELEASE);
+	flush_pending(*cb);
+	if (cb->buffered || cb->key_callback) deliver(*cb, cb->key_callback, e);
+#ifdef GLFWHPP_COROUTINES
+	if (cb->key_waiters) {
+		resume_waiters(cb->key_waiters, e);
+		settle_awaited(sourceWindow);
+	}
+#endif
+}
+
+inline void glfw_char_callback(GLFWwindow* sourceWindow, uint32_t codepoint) {
+	uint64_t timestamp = glfwGetTimerValue();
+	auto cb = find(sourceWindow);
+	if (!cb) return;
+	char_event e{ window_ref{sourceWindow}, code_point{codepoint}, timestamp };
+	record(make_event(cb->id, e));
+	flush_pending(*cb);
+	deliver(*cb, cb->char_callback, e);
+}
+
+inline void add_sample(coalesced_samples& samples, uint64_t timestamp) {
+	if (samples.count++ == 0) samples.firstTimestamp = timestamp;
+	samples.lastTimestamp = timestamp;
+}
+
+inline void mark_coalesce_pending(window_callbacks& cb) {
+	if (!cb.coalesce_pending) {
+		cb.coalesce_pending = true;
+		coalesced_windows.push_back(&cb);
+	}
+}
+
+inline void flush_pending_cursor(window_callbacks& cb) {
+	if (!cb.pending_cursor_samples.count) return;
+	cb.cursor_samples = std::exchange(cb.pending_cursor_samples, coalesced_samples{});
+	deliver(cb, cb.cursor_callback, cursor_event{ window_ref{ cb.handle }, cb.pending_cursor, cb.cursor_samples.firstTimestamp });
+}
+
+inline void flush_pending_scroll(window_callbacks& cb) {
+	if (!cb.pending_scroll_samples.count) return;
+	cb.scroll_samples = std::exchange(cb.pending_scroll_samples, coalesced_samples{});
+	deliver(cb, cb.mouse_scroll_callback, mouse_scroll_event{ window_ref{ cb.handle }, std::exchange(cb.pending_scroll, mouse_scroll_offset{}), cb.scroll_samples.firstTimestamp });
+}
+
+/* Delivers a window's coalesced cursor / scroll input ahead of one of its other events, so a click sees the position it
+ * happened at and buffered batches stay in timestamp order. The window stays listed, flush_coalesced finds nothing pending. */
+inline void flush_pending(window_callbacks& cb) {
+	if (!cb.coalesce_pending) return;
+	cb.coalesce_pending = false;
+	flush_pending_cursor(cb);
+	flush_pending_scroll(cb);
+}
+
+inline void glfw_cursor_callback(GLFWwindow* sourceWindow, double xpos, double ypos) {
+	uint64_t timestamp = glfwGetTimerValue();
+	auto cb = find(sourceWindow);
+	if (!cb) return;
+	cursor_event e{ window_ref{sourceWindow}, cursor_position{xpos,ypos}, timestamp };
+	//raw samples are recorded, replay goes through the coalescing again
+	record(make_event(cb->id, e));
+	if (cb->cursor_policy == coalesce_policy::PerPoll) {
+		cb->pending_cursor = e.pos;
+		add_sample(cb->pending_cursor_samples, timestamp);
+		mark_coalesce_pending(*cb);
+	}
+	else deliver(*cb, cb->cursor_callback, e);
+}
+
+inline void glfw_cursor_enter_callback(GLFWwindow* sourceWindow, int entered) {
+	uint64_t timestamp = glfwGetTimerValue();
+	auto cb = find(sourceWindow);
+	if (!cb) return;
+	cursor_enter_event e{ window_ref{sourceWindow}, entered == GLFW_TRUE, timestamp };
+	record(make_event(cb->id, e));
+	if (cb->state_cache) cb->state_cache->hovered = e.entered;
+	flush_pending(*cb);
+	deliver(*cb, cb->cursor_enter_callback, e);
+}
+
+inline void glfw_mouse_button_callback(GLFWwindow* sourceWindow, int button, int action, int mods) {
+	uint64_t timestamp = glfwGetTimerValue();
+	auto cb = find(sourceWindow);
+	if (!cb) return;
+	mouse_button_event e{ window_ref{sourceWindow}, mouse_button{button}, mouse_button_action{action}, modifier_flags{mods}, timestamp };
+	record(make_event(cb->id, e));
+	if (cb->input) cb->input->set(mouse_button{button}, action == GLFW_PRESS);
+	flush_pending(*cb);
+	if (cb->buffered || cb->mouse_button_callback) deliver(*cb, cb->mouse_button_callback, e);
+#ifdef GLFWHPP_COROUTINES
+	if (cb->mouse_button_waiters) {
+		resume_waiters(cb->mouse_button_waiters, e);
+		settle_awaited(sourceWindow);
+	}
+#endif
+}
+
+inline void glfw_mouse_scroll_callback(GLFWwindow* sourceWindow, double xOffset, double yOffset) {
+	uint64_t timestamp = glfwGetTimerValue();
+	auto cb = find(sourceWindow);
+	if (!cb) return;
+	mouse_scroll_event e{ window_ref{sourceWindow}, mouse_scroll_offset{xOffset, yOffset}, timestamp };
+	record(make_event(cb->id, e));
+	if (cb->scroll_policy == coalesce_policy::PerPoll) {
+		cb->pending_scroll.xOffset += xOffset;
+		cb->pending_scroll.yOffset += yOffset;
+		add_sample(cb->pending_scroll_samples, timestamp);
+		mark_coalesce_pending(*cb);
+	}
+	else deliver(*cb, cb->mouse_scroll_callback, e);
+}
+
+/* moves the tracked input state of every window to the next frame, called before each poll */
+inline void begin_input_frame() {
+	for (auto& cb : window_slots) if (cb && cb->input) cb->input->next_frame();
+}
+
+/* delivers the coalesced cursor / scroll input of the last poll, once per window */
+inline void flush_coalesced() {
+	//callbacks may register new coalesced input or destroy windows, the walked list is indexed and re-read after each delivery
+	flushing_windows.swap(coalesced_windows);
+	for (size_t i = 0; i < flushing_windows.size(); ++i) {
+		if (auto cb = flushing_windows[i]) {
+			cb->coalesce_pending = false;
+			flush_pending_cursor(*cb);
+		}
+		if (auto cb = flushing_windows[i]) flush_pending_scroll(*cb);
+	}
+	flushing_windows.clear();
+}
+
+
+
+inline void glfw_joystick_callback(int id, int event) {
+	uint64_t timestamp = glfwGetTimerValue();
+	auto e = make_event(event::no_window, event_type::Joystick, timestamp);
+	e.joystick = { static_cast<uint8_t>(id), event == GLFW_CONNECTED };
+	record(e);
+	if (buffer_joystick_events) thread_events.push(e);
+	else if (joystick_callback) joystick_callback(joystick_event{ joystick_id{id}, joystick_state{event}, timestamp });
+}
+
+/* installs exactly the trampolines needed by the registered callbacks and the buffering mode of a window */
+inline void update_trampolines(GLFWwindow* window) {
+	auto& cb = acquire(window);
+	auto needs = [&](auto const& callback) { return recording_input || cb.buffered || static_cast<bool>(callback); };
+	auto needsWindowEvent = [&](window_event_type eventType) { return recording_input || cb.buffered || (cb.window_callback.callback && (cb.window_callback.mask & eventType)); };
+	//slots taken over by a static handler are left alone
+	auto install = [&](uint32_t slot, auto setter, auto trampoline, bool needed) {
+		if (!(cb.handler_slots & slot)) setter(window, needed ? trampoline : nullptr);
+	};
+
+	install(KEY_TRAMPOLINE, &glfwSetKeyCallback, &glfw_key_callback, cb.input || cb.awaited || needs(cb.key_callback));
+	install(CHAR_TRAMPOLINE, &glfwSetCharCallback, &glfw_char_callback, needs(cb.char_callback));
+	install(CURSOR_TRAMPOLINE, &glfwSetCursorPosCallback, &glfw_cursor_callback, needs(cb.cursor_callback));
+	install(CURSOR_ENTER_TRAMPOLINE, &glfwSetCursorEnterCallback, &glfw_cursor_enter_callback, cb.state_cache || needs(cb.cursor_enter_callback));
+	install(MOUSE_BUTTON_TRAMPOLINE, &glfwSetMouseButtonCallback, &glfw_mouse_button_callback, cb.input || cb.awaited || needs(cb.mouse_button_callback));
+	install(SCROLL_TRAMPOLINE, &glfwSetScrollCallback, &glfw_mouse_scroll_callback, needs(cb.mouse_scroll_callback));
+	install(DROP_TRAMPOLINE, &glfwSetDropCallback, &glfw_drop_callback, needs(cb.drop_callback));
+
+	install(POSITION_CHANGED, &glfwSetWindowPosCallback, &glfw_window_pos_callback, cb.geometry_cache || needsWindowEvent(POSITION_CHANGED));
+	install(SIZE_CHANGED, &glfwSetWindowSizeCallback, &glfw_window_size_callback, cb.geometry_cache || needsWindowEvent(SIZE_CHANGED));
+	install(FRAMEBUFFER_SIZE_CHANGED, &glfwSetFramebufferSizeCallback, &glfw_framebuffer_size_callback, cb.geometry_cache || needsWindowEvent(FRAMEBUFFER_SIZE_CHANGED));
+	install(CONTENT_SCALE_CHANGED, &glfwSetWindowContentScaleCallback, &glfw_window_content_scale_callback, cb.geometry_cache || needsWindowEvent(CONTENT_SCALE_CHANGED));
+	install(FOCUS_CHANGED, &glfwSetWindowFocusCallback, &glfw_window_focus_callback, cb.state_cache || needsWindowEvent(FOCUS_CHANGED));
+	install(MINIMIZE_STATE_CHANGED, &glfwSetWindowIconifyCallback, &glfw_window_minimize_callback, cb.state_cache || needsWindowEvent(MINIMIZE_STATE_CHANGED));
+	install(MAXIMIZE_STATE_CHANGED, &glfwSetWindowMaximizeCallback, &glfw_window_maximize_callback, cb.state_cache || needsWindowEvent(MAXIMIZE_STATE_CHANGED));
+	install(CONTENT_NEEDS_REFRESH, &glfwSetWindowRefreshCallback, &glfw_window_refresh_callback, needsWindowEvent(CONTENT_NEEDS_REFRESH));
+	install(CLOSE_REQUESTED, &glfwSetWindowCloseCallback, &glfw_window_close_callback, needsWindowEvent(CLOSE_REQUESTED));
+}
+
+inline void update_joystick_trampoline() {
+	glfwSetJoystickCallback(recording_input || buffer_joystick_events || joystick_callback ? &glfw_joystick_callback : nullptr);
+}
+}
+}
+
+enum class key_input_mode : int {
+	StickyKeys,
+	LockKeyModifiers,
+};
+
+enum class cursor_input_mode : int {
+	Normal = GLFW_CURSOR_NORMAL,
+	Disabled = GLFW_CURSOR_DISABLED,
+	Hidden = GLFW_CURSOR_HIDDEN,
+};
+
+namespace detail {
+//internal gamepad mappings
+inline std::array<GLFWgamepadstate, GLFW_JOYSTICK_LAST + 1> gamepad_states;
+}
+
+enum class gamepad_button_state : unsigned char {
+	Pressed = GLFW_PRESS,
+	Released = GLFW_RELEASE,
+};
+
+struct gamepad_state {
+	struct gamepad_buttons {
 		using button = unsigned char;
 		button* gamepad_buttons;
 		gamepad_button_state operator[](gamepad_button buttonIndex) { return gamepad_button_state{ gamepad_buttons[static_cast<size_t>(buttonIndex)] }; }
@@ -1425,6 +3295,168 @@ struct gamepad_state {
 	static constexpr size_t AXES_COUNT = GLFW_GAMEPAD_AXIS_LAST + 1;
 };
 
+/* Structure-of-arrays state of every gamepad, filled in one pass by input::poll_all_gamepads.
+ * Bit n of a pad_mask is joystick n, bit n of a button_mask is gamepad_button n.
+ * axes[axis] holds one axis of all pads contiguously, disconnected pads read as neutral. */
+struct gamepad_snapshot {
+	static constexpr size_t PAD_COUNT = GLFW_JOYSTICK_LAST + 1;
+	using pad_mask = uint16_t;
+	using button_mask = uint16_t;
+	using axis_table = std::array<std::array<float, PAD_COUNT>, gamepad_state::AXES_COUNT>;
+	static_assert(PAD_COUNT <= 16 && gamepad_state::BUTTON_COUNT <= 16);
+
+	pad_mask connected = 0;
+	pad_mask connection_changed = 0;
+	/* pads whose connection, buttons or axes changed since the previous poll */
+	pad_mask dirty = 0;
+	std::array<button_mask, PAD_COUNT> buttons = {};
+	std::array<button_mask, PAD_COUNT> pressed = {};
+	std::array<button_mask, PAD_COUNT> released = {};
+	axis_table axes = {};
+
+	bool is_connected(joystick_id joystick) const { return connected & pad_bit(joystick); }
+	bool is_dirty(joystick_id joystick) const { return dirty & pad_bit(joystick); }
+	bool is_down(joystick_id joystick, gamepad_button button) const { return buttons[pad(joystick)] & button_bit(button); }
+	bool was_pressed(joystick_id joystick, gamepad_button button) const { return pressed[pad(joystick)] & button_bit(button); }
+	bool was_released(joystick_id joystick, gamepad_button button) const { return released[pad(joystick)] & button_bit(button); }
+	float axis(joystick_id joystick, gamepad_axis axis) const { return axes[static_cast<size_t>(axis)][pad(joystick)]; }
+
+	static size_t pad(joystick_id joystick) { return static_cast<size_t>(joystick); }
+	static pad_mask pad_bit(joystick_id joystick) { return static_cast<pad_mask>(1u << pad(joystick)); }
+	static button_mask button_bit(gamepad_button button) { return static_cast<button_mask>(1u << static_cast<size_t>(button)); }
+};
+
+namespace detail {
+inline gamepad_snapshot gamepads;
+}
+
+enum class deadzone_shape : uint8_t {
+	None,
+	/* per axis, snaps sticks to the axes near the center */
+	Axial,
+	/* on the stick magnitude, keeps the direction */
+	Radial,
+};
+
+/* applied to the deadzone-rescaled magnitude in [0, 1] */
+enum class response_curve : uint8_t {
+	Linear,
+	Quadratic,
+	Cubic,
+};
+
+struct axis_filter {
+	deadzone_shape shape = deadzone_shape::Radial;
+	/* magnitudes up to inner read as 0, from outer on as 1 */
+	float inner = 0.1f;
+	float outer = 1.0f;
+	response_curve curve = response_curve::Linear;
+};
+
+/* per pad and axis: calibrated = (raw - center) * scale */
+struct axis_calibration {
+	gamepad_snapshot::axis_table center = {};
+	gamepad_snapshot::axis_table scale;
+
+	axis_calibration() { for (auto& axis : scale) axis.fill(1.0f); }
+};
+
+/* Filters the axes of all pads of a gamepad_snapshot at once: calibration, deadzone, response curve.
+ * Sticks come out in [-1, 1], triggers are normalized to [0, 1].
+ * Every stage runs branch-free over the contiguous pad lanes of one axis, so the cost does not depend on which pads are connected. */
+class axis_processor {
+public:
+	using axis_table = gamepad_snapshot::axis_table;
+	static constexpr size_t PAD_COUNT = gamepad_snapshot::PAD_COUNT;
+
+	axis_filter sticks;
+	axis_filter triggers{ deadzone_shape::Axial, 0.05f, 1.0f, response_curve::Linear };
+	axis_calibration calibration;
+
+	/* takes the current resting position of the pad's sticks as their center, triggers keep resting at -1 */
+	void calibrate_center(gamepad_snapshot const& snapshot, joystick_id joystick) {
+		auto pad = gamepad_snapshot::pad(joystick);
+		for (auto axis : { gamepad_axis::LeftX, gamepad_axis::LeftY, gamepad_axis::RightX, gamepad_axis::RightY }) {
+			calibration.center[axis_index(axis)][pad] = snapshot.axes[axis_index(axis)][pad];
+		}
+	}
+
+	axis_table const& process(gamepad_snapshot const& snapshot) {
+		for (size_t axis = 0; axis < gamepad_state::AXES_COUNT; ++axis) {
+			auto const& raw = snapshot.axes[axis];
+			auto const& center = calibration.center[axis];
+			auto const& scale = calibration.scale[axis];
+			auto& out = m_output[axis];
+			for (size_t pad = 0; pad < PAD_COUNT; ++pad) out[pad] = std::clamp((raw[pad] - center[pad]) * scale[pad], -1.0f, 1.0f);
+		}
+
+		filter_stick(axis_index(gamepad_axis::LeftX), axis_index(gamepad_axis::LeftY));
+		filter_stick(axis_index(gamepad_axis::RightX), axis_index(gamepad_axis::RightY));
+		filter_trigger(axis_index(gamepad_axis::LeftTrigger));
+		filter_trigger(axis_index(gamepad_axis::RightTrigger));
+		return m_output;
+	}
+
+	float axis(joystick_id joystick, gamepad_axis axis) const { return m_output[axis_index(axis)][gamepad_snapshot::pad(joystick)]; }
+	axis_table const& output() const { return m_output; }
+
+private:
+	static constexpr size_t axis_index(gamepad_axis axis) { return static_cast<size_t>(axis); }
+
+	static float shape(float magnitude, axis_filter const& filter) {
+		float range = std::max(filter.outer - filter.inner, 1e-6f);
+		float value = std::clamp((magnitude - filter.inner) / range, 0.0f, 1.0f);
+		switch (filter.curve) {
+		case response_curve::Quadratic: return value * value;
+		case response_curve::Cubic: return value * value * value;
+		default: return value;
+		}
+	}
+
+	void filter_axial(std::array<float, PAD_COUNT>& values, axis_filter const& filter) {
+		for (auto& value : values) value = std::copysign(shape(std::abs(value), filter), value);
+	}
+
+	void filter_stick(size_t xAxis, size_t yAxis) {
+		auto& xs = m_output[xAxis];
+		auto& ys = m_output[yAxis];
+		if (sticks.shape != deadzone_shape::Radial) {
+			axis_filter filter = sticks;
+			if (filter.shape == deadzone_shape::None) filter.inner = 0.0f;
+			filter_axial(xs, filter);
+			filter_axial(ys, filter);
+			return;
+		}
+		for (size_t pad = 0; pad < PAD_COUNT; ++pad) {
+			float magnitude = std::sqrt(xs[pad] * xs[pad] + ys[pad] * ys[pad]);
+			float factor = shape(magnitude, sticks) / std::max(magnitude, 1e-6f);
+			xs[pad] = std::clamp(xs[pad] * factor, -1.0f, 1.0f);
+			ys[pad] = std::clamp(ys[pad] * factor, -1.0f, 1.0f);
+		}
+	}
+
+	void filter_trigger(size_t triggerAxis) {
+		axis_filter filter = triggers;
+		if (filter.shape == deadzone_shape::None) filter.inner = 0.0f;
+		for (auto& value : m_output[triggerAxis]) value = shape((value + 1.0f) * 0.5f, filter);
+	}
+
+	axis_table m_output = {};
+};
+
+/* Raw window handles: the free functions taking a GLFWwindow* (input, window_events, buffered_events, render_threads,
+ * cached_state, cached_geometry, handler, async) attach a callback block to windows not created through glfw::window too.
+ * glfw::window releases it on destruction, a raw window has to be destroyed with destroy_window instead of
+ * glfwDestroyWindow, or passed to release_window first. Otherwise its block outlives the window. */
+inline void release_window(GLFWwindow* window) { detail::callbacks::release(window); }
+
+inline void destroy_window(GLFWwindow* window) {
+	if (!window) return;
+	detail::callbacks::release(window);
+	glfwDestroyWindow(window);
+}
+
+/* raw handles: see destroy_window */
 namespace input {
 
 /* Keyboard and Mouse */
@@ -1443,6 +3475,25 @@ inline cursor_position current_get_cursor_position(GLFWwindow* window) {
 inline mouse_button_action get_mouse_button_action(GLFWwindow* window, mouse_button button) {
 	return mouse_button_action{ glfwGetMouseButton(window, static_cast<int>(button)) };
 }
+
+/* Tracked input state: the key and mouse button trampolines keep the returned table up to date, queries do not call into GLFW.
+ * Keys already held while enabling are reported once GLFW sends their next event. */
+inline input_state const& enable_input_state(GLFWwindow* window) {
+	auto& cb = detail::callbacks::acquire(window);
+	if (!cb.input) cb.input = std::make_unique<input_state>();
+	detail::callbacks::update_trampolines(window);
+	return *cb.input;
+}
+inline void disable_input_state(GLFWwindow* window) {
+	detail::callbacks::acquire(window).input.reset();
+	detail::callbacks::update_trampolines(window);
+}
+/* nullptr while the window does not track its input state */
+inline input_state const* get_input_state(GLFWwindow* window) {
+	auto cb = detail::callbacks::find(window);
+	return cb ? cb->input.get() : nullptr;
+}
+
 inline void set_sticky_mouse_input_mode(GLFWwindow* window, bool enabled) { glfwSetInputMode(window, GLFW_STICKY_MOUSE_BUTTONS, enabled ? TRUE : FALSE); }
 inline void set_cursor_input_mode(GLFWwindow* window, cursor_input_mode mode) {
 	glfwSetInputMode(window, GLFW_CURSOR, static_cast<int>(mode));
@@ -1454,73 +3505,103 @@ inline void use_raw_cursor(GLFWwindow* window, bool enabled = true) {
 template<class KeyCallback>
 inline void set_key_callback(GLFWwindow* window, KeyCallback&& callback) {
 	static_assert(std::is_invocable_v<KeyCallback, key_event>);
-	detail::glfw_callbacks::key_callbacks[window] = std::forward<KeyCallback>(callback);
-	glfwSetKeyCallback(window, &detail::glfw_callbacks::glfw_key_callback);
+	detail::callbacks::acquire(window).key_callback = std::forward<KeyCallback>(callback);
+	detail::callbacks::update_trampolines(window);
 }
 
 inline void set_key_callback(GLFWwindow* window, std::nullptr_t) {
-	detail::glfw_callbacks::key_callbacks[window] = nullptr;
-	glfwSetKeyCallback(window, nullptr);
+	detail::callbacks::acquire(window).key_callback = nullptr;
+	detail::callbacks::update_trampolines(window);
 }
 
 template<class CharCallback>
 inline void set_char_callback(GLFWwindow* window, CharCallback&& callback) {
 	static_assert(std::is_invocable_v<CharCallback, char_event>);
-	detail::glfw_callbacks::char_callbacks[window] = std::forward<CharCallback>(callback);
-	glfwSetCharCallback(window, &detail::glfw_callbacks::glfw_char_callback);
+	detail::callbacks::acquire(window).char_callback = std::forward<CharCallback>(callback);
+	detail::callbacks::update_trampolines(window);
 }
 
 inline void set_char_callback(GLFWwindow* window, std::nullptr_t) {
-	detail::glfw_callbacks::char_callbacks[window] = nullptr;
-	glfwSetCharCallback(window, nullptr);
+	detail::callbacks::acquire(window).char_callback = nullptr;
+	detail::callbacks::update_trampolines(window);
 }
 
 template<class CursorCallback>
-inline void set_cursor_callback(GLFWwindow* window, CursorCallback&& callback) {
+inline void set_cursor_callback(GLFWwindow* window, CursorCallback&& callback, coalesce_policy policy = coalesce_policy::None) {
 	static_assert(std::is_invocable_v<CursorCallback, cursor_event>);
-	detail::glfw_callbacks::cursor_callbacks[window] = std::forward<CursorCallback>(callback);
-	glfwSetCursorPosCallback(window, &detail::glfw_callbacks::glfw_cursor_callback);
+	auto& cb = detail::callbacks::acquire(window);
+	cb.cursor_callback = std::forward<CursorCallback>(callback);
+	cb.cursor_policy = policy;
+	detail::callbacks::update_trampolines(window);
 }
 
+/* also drops the coalesce policy and the cursor input coalesced so far */
 inline void set_cursor_callback(GLFWwindow* window, std::nullptr_t) {
-	detail::glfw_callbacks::cursor_callbacks[window] = nullptr;
-	glfwSetCursorPosCallback(window, nullptr);
+	auto& cb = detail::callbacks::acquire(window);
+	cb.cursor_callback = nullptr;
+	cb.cursor_policy = coalesce_policy::None;
+	cb.pending_cursor_samples = {};
+	detail::callbacks::update_trampolines(window);
 }
 
 template<class CursorEnterCallback>
 inline void set_cursor_enter_callback(GLFWwindow* window, CursorEnterCallback&& callback) {
 	static_assert(std::is_invocable_v<CursorEnterCallback, cursor_enter_event>);
-	detail::glfw_callbacks::cursor_enter_callbacks[window] = std::forward<CursorEnterCallback>(callback);
-	glfwSetCursorEnterCallback(window, &detail::glfw_callbacks::glfw_cursor_enter_callback);
+	detail::callbacks::acquire(window).cursor_enter_callback = std::forward<CursorEnterCallback>(callback);
+	detail::callbacks::update_trampolines(window);
 }
 
 inline void set_cursor_enter_callback(GLFWwindow* window, std::nullptr_t) {
-	detail::glfw_callbacks::cursor_enter_callbacks[window] = nullptr;
-	glfwSetCursorEnterCallback(window, nullptr);
+	detail::callbacks::acquire(window).cursor_enter_callback = nullptr;
+	detail::callbacks::update_trampolines(window);
 }
 
 template<class MouseButtonCallback>
 inline void set_mouse_button_callback(GLFWwindow* window, MouseButtonCallback&& callback) {
 	static_assert(std::is_invocable_v<MouseButtonCallback, mouse_button_event>);
-	detail::glfw_callbacks::mouse_button_callbacks[window] = std::forward<MouseButtonCallback>(callback);
-	glfwSetMouseButtonCallback(window, &detail::glfw_callbacks::glfw_mouse_button_callback);
+	detail::callbacks::acquire(window).mouse_button_callback = std::forward<MouseButtonCallback>(callback);
+	detail::callbacks::update_trampolines(window);
 }
 
 inline void set_mouse_button_callback(GLFWwindow* window, std::nullptr_t) {
-	detail::glfw_callbacks::mouse_button_callbacks[window] = nullptr;
-	glfwSetMouseButtonCallback(window, nullptr);
+	detail::callbacks::acquire(window).mouse_button_callback = nullptr;
+	detail::callbacks::update_trampolines(window);
 }
 
 template<class MouseScrollCallback>
-inline void set_mouse_scroll_callback(GLFWwindow* window, MouseScrollCallback&& callback) {
+inline void set_mouse_scroll_callback(GLFWwindow* window, MouseScrollCallback&& callback, coalesce_policy policy = coalesce_policy::None) {
 	static_assert(std::is_invocable_v<MouseScrollCallback, mouse_scroll_event>);
-	detail::glfw_callbacks::mouse_scroll_callbacks[window] = std::forward<MouseScrollCallback>(callback);
-	glfwSetScrollCallback(window, &detail::glfw_callbacks::glfw_mouse_scroll_callback);
+	auto& cb = detail::callbacks::acquire(window);
+	cb.mouse_scroll_callback = std::forward<MouseScrollCallback>(callback);
+	cb.scroll_policy = policy;
+	detail::callbacks::update_trampolines(window);
 }
 
+/* also drops the coalesce policy and the scroll input coalesced so far */
 inline void set_mouse_scroll_callback(GLFWwindow* window, std::nullptr_t) {
-	detail::glfw_callbacks::mouse_scroll_callbacks[window] = nullptr;
-	glfwSetScrollCallback(window, nullptr);
+	auto& cb = detail::callbacks::acquire(window);
+	cb.mouse_scroll_callback = nullptr;
+	cb.scroll_policy = coalesce_policy::None;
+	cb.pending_scroll = {};
+	cb.pending_scroll_samples = {};
+	detail::callbacks::update_trampolines(window);
+}
+
+/* coalescing for buffered windows, which have no callback to carry the policy */
+inline void set_cursor_coalesce_policy(GLFWwindow* window, coalesce_policy policy) { detail::callbacks::acquire(window).cursor_policy = policy; }
+inline void set_scroll_coalesce_policy(GLFWwindow* window, coalesce_policy policy) { detail::callbacks::acquire(window).scroll_policy = policy; }
+
+/* Samples folded into the most recently delivered coalesced cursor / scroll event of the window. These count per
+ * delivered event, not per poll: another event of the window flushes the input coalesced before it, so such a poll
+ * delivers several coalesced events and only the samples of the last one are reported here. */
+inline coalesced_samples last_cursor_samples(GLFWwindow* window) {
+	auto cb = detail::callbacks::find(window);
+	return cb ? cb->cursor_samples : coalesced_samples{};
+}
+
+inline coalesced_samples last_scroll_samples(GLFWwindow* window) {
+	auto cb = detail::callbacks::find(window);
+	return cb ? cb->scroll_samples : coalesced_samples{};
 }
 
 /* Joystick / Controllers */
@@ -1543,13 +3624,13 @@ T set_joystick_user_pointer(joystick_id joystick, T userPointer) {
 template<class JoystickCallback>
 inline void set_joystick_callback(JoystickCallback&& callback) {
 	static_assert(std::is_invocable_v<JoystickCallback, joystick_event>);
-	detail::glfw_callbacks::joystick_callback = std::forward<JoystickCallback>(callback);
-	glfwSetJoystickCallback(&detail::glfw_callbacks::glfw_joystick_callback);
+	detail::callbacks::joystick_callback = std::forward<JoystickCallback>(callback);
+	detail::callbacks::update_joystick_trampoline();
 }
 
 inline void set_joystick_callback(std::nullptr_t) {
-	detail::glfw_callbacks::joystick_callback = nullptr;
-	glfwSetJoystickCallback(nullptr);
+	detail::callbacks::joystick_callback = nullptr;
+	detail::callbacks::update_joystick_trampoline();
 }
 
 /* Gamepad */
@@ -1567,6 +3648,47 @@ inline gamepad_state current_gamepad_state(joystick_id joystick) {
 	glfwGetGamepadState(static_cast<int>(joystick), state);
 	return gamepad_state{ state->buttons, state->axes };
 }
+
+/* Polls every joystick slot once and updates the shared gamepad snapshot, including the edges since the previous call.
+ * Only pads flagged in dirty need processing. */
+inline gamepad_snapshot const& poll_all_gamepads() {
+	auto& snapshot = detail::gamepads;
+	gamepad_snapshot::pad_mask connected = 0;
+	gamepad_snapshot::pad_mask dirty = 0;
+
+	for (size_t pad = 0; pad < gamepad_snapshot::PAD_COUNT; ++pad) {
+		GLFWgamepadstate state{};
+		bool present = glfwGetGamepadState(static_cast<int>(pad), &state) == GLFW_TRUE;
+		auto padBit = static_cast<gamepad_snapshot::pad_mask>(1u << pad);
+		if (present) connected |= padBit;
+		else {
+			//released triggers rest at -1
+			state.axes[GLFW_GAMEPAD_AXIS_LEFT_TRIGGER] = -1.0f;
+			state.axes[GLFW_GAMEPAD_AXIS_RIGHT_TRIGGER] = -1.0f;
+		}
+
+		gamepad_snapshot::button_mask buttons = 0;
+		for (size_t button = 0; button < gamepad_state::BUTTON_COUNT; ++button)
+			buttons |= static_cast<gamepad_snapshot::button_mask>((state.buttons[button] == GLFW_PRESS) << button);
+
+		bool changed = false;
+		for (size_t axis = 0; axis < gamepad_state::AXES_COUNT; ++axis) {
+			changed |= snapshot.axes[axis][pad] != state.axes[axis];
+			snapshot.axes[axis][pad] = state.axes[axis];
+		}
+
+		auto previous = snapshot.buttons[pad];
+		snapshot.pressed[pad] = buttons & ~previous;
+		snapshot.released[pad] = ~buttons & previous;
+		snapshot.buttons[pad] = buttons;
+		if (present && (changed || buttons != previous)) dirty |= padBit;
+	}
+
+	snapshot.connection_changed = connected ^ snapshot.connected;
+	snapshot.connected = connected;
+	snapshot.dirty = dirty | snapshot.connection_changed;
+	return snapshot;
+}
 }
 
 
@@ -1575,77 +3697,1386 @@ namespace monitor_events {
 template<class MonitorCallback>
 inline void set_event_callback(MonitorCallback&& callback) {
 	static_assert(std::is_invocable_v<MonitorCallback, monitor_event>);
-	detail::glfw_callbacks::monitor_callback = std::forward<MonitorCallback>(callback);
-	glfwSetMonitorCallback(&detail::glfw_callbacks::glfw_monitor_callback);
+	detail::callbacks::monitor_callback = std::forward<MonitorCallback>(callback);
+	glfwSetMonitorCallback(&detail::callbacks::glfw_monitor_callback);
 }
 
 inline void set_event_callback(std::nullptr_t) {
-	detail::glfw_callbacks::monitor_callback = nullptr;
-	glfwSetMonitorCallback(nullptr);
+	detail::callbacks::monitor_callback = nullptr;
+	if (!detail::monitor_registry.enabled) glfwSetMonitorCallback(nullptr);
 }
 
 };
 
+/* Monitor registry: snapshots every monitor once and refreshes on the monitor connect / disconnect callback, the monitor
+ * getters then answer from the snapshot. Video mode, work area and content scale changes without a connection change
+ * (set_fullscreen with a video mode, taskbar moves, scale settings) are not reported by GLFW, call refresh after those. */
+namespace monitor_registry {
+inline void enable() {
+	auto& registry = detail::monitor_registry;
+	if (!registry.enabled) {
+		detail::refresh_monitor_registry();
+		registry.enabled = true;
+	}
+	glfwSetMonitorCallback(&detail::callbacks::glfw_monitor_callback);
+}
+
+inline void disable() {
+	detail::monitor_registry.enabled = false;
+	if (!detail::callbacks::monitor_callback) glfwSetMonitorCallback(nullptr);
+}
+
+inline bool is_enabled() { return detail::monitor_registry.enabled; }
+
+inline void refresh() {
+	if (detail::monitor_registry.enabled) detail::refresh_monitor_registry();
+}
+
+/* valid until the next refresh, empty while disabled */
+inline std::vector<monitor_info> const& monitors() {
+	static std::vector<monitor_info> const none;
+	return detail::monitor_registry.enabled ? detail::monitor_registry.monitors : none;
+}
+
+inline monitor_info const* primary() {
+	for (auto const& info : monitors()) {
+		if (info.primary) return &info;
+	}
+	return nullptr;
+}
+
+inline monitor_info const* find(GLFWmonitor* handle) { return detail::find_monitor_info(handle); }
+
+/* changes with every refresh, 0 while never enabled */
+inline uint64_t generation() { return detail::monitor_registry.generation; }
+}
+
 
+/* raw handles: see destroy_window */
 namespace window_events {
 
 template<class WindowCallback>
 inline void set_event_callback(GLFWwindow* window, WindowCallback&& callback, window_event_type mask) {
 	static_assert(std::is_invocable_v<WindowCallback, window_ref>);
 
-	detail::glfw_callbacks::window_callbacks[window] = detail::window_callback{ std::forward<WindowCallback>(callback), mask };
-
-	glfwSetWindowPosCallback(window, (mask & POSITION_CHANGED) == 1 ? &detail::glfw_callbacks::glfw_window_pos_callback : nullptr);
-	glfwSetWindowSizeCallback(window, (mask & SIZE_CHANGED) == 1 ? &detail::glfw_callbacks::glfw_window_size_callback : nullptr);
-	glfwSetFramebufferSizeCallback(window, (mask & FRAMEBUFFER_SIZE_CHANGED) == 1 ? &detail::glfw_callbacks::glfw_framebuffer_size_callback : nullptr);
-	glfwSetWindowContentScaleCallback(window, (mask & CONTENT_SCALE_CHANGED) == 1 ? &detail::glfw_callbacks::glfw_window_content_scale_callback : nullptr);
-	glfwSetWindowFocusCallback(window, (mask & FOCUS_CHANGED) == 1 ? &detail::glfw_callbacks::glfw_window_focus_callback : nullptr);
-	glfwSetWindowIconifyCallback(window, (mask & MINIMIZE_STATE_CHANGED) == 1 ? &detail::glfw_callbacks::glfw_window_minimize_callback : nullptr);
-	glfwSetWindowMaximizeCallback(window, (mask & MAXIMIZE_STATE_CHANGED) == 1 ? &detail::glfw_callbacks::glfw_window_maximize_callback : nullptr);
-	glfwSetWindowRefreshCallback(window, (mask & CONTENT_NEEDS_REFRESH) == 1 ? &detail::glfw_callbacks::glfw_window_refresh_callback : nullptr);
-	glfwSetWindowCloseCallback(window, (mask & CLOSE_REQUESTED) == 1 ? &detail::glfw_callbacks::glfw_window_close_callback : nullptr);
+	detail::callbacks::acquire(window).window_callback = detail::window_callback{ std::forward<WindowCallback>(callback), mask };
+	detail::callbacks::update_trampolines(window);
 }
 
 inline void set_event_callback(GLFWwindow* window, std::nullptr_t) {
-	detail::glfw_callbacks::window_callbacks[window].callback = nullptr;
-
-	glfwSetWindowPosCallback(window, nullptr);
-	glfwSetWindowSizeCallback(window, nullptr);
-	glfwSetFramebufferSizeCallback(window, nullptr);
-	glfwSetWindowContentScaleCallback(window, nullptr);
-	glfwSetWindowFocusCallback(window, nullptr);
-	glfwSetWindowIconifyCallback(window, nullptr);
-	glfwSetWindowMaximizeCallback(window, nullptr);
-	glfwSetWindowRefreshCallback(window, nullptr);
-	glfwSetWindowCloseCallback(window, nullptr);
+	detail::callbacks::acquire(window).window_callback.callback = nullptr;
+	detail::callbacks::update_trampolines(window);
 }
 
 template<class DropCallback>
 inline void set_drop_callback(GLFWwindow* window, DropCallback&& callback) {
 	static_assert(std::is_invocable_v<DropCallback, drop_event>);
 
-	detail::glfw_callbacks::drop_callbacks[window] = std::forward<DropCallback>(callback);
-	glfwSetDropCallback(window, &detail::glfw_callbacks::glfw_drop_callback);
+	detail::callbacks::acquire(window).drop_callback = std::forward<DropCallback>(callback);
+	detail::callbacks::update_trampolines(window);
 }
 
 inline void set_drop_callback(GLFWwindow* window, std::nullptr_t) {
-	detail::glfw_callbacks::drop_callbacks[window] = nullptr;
-	glfwSetDropCallback(window, nullptr);
+	detail::callbacks::acquire(window).drop_callback = nullptr;
+	detail::callbacks::update_trampolines(window);
 }
 }
 
 
+inline GLFWwindow* event::source() const {
+	return detail::callbacks::window_from_id(window_id);
+}
+
+/* Buffered mode: instead of calling the registered callbacks from inside glfwPollEvents, the trampolines of
+ * a buffered window only append compact event records to a per-thread queue. poll_events / wait_events
+ * return these records as one batch, so all input of a frame can be processed in a single loop.
+ * Raw handles: see destroy_window. */
+namespace buffered_events {
+
+inline void enable(GLFWwindow* window) {
+	detail::callbacks::acquire(window).buffered = true;
+	detail::callbacks::update_trampolines(window);
+}
+
+inline void disable(GLFWwindow* window) {
+	detail::callbacks::acquire(window).buffered = false;
+	detail::callbacks::update_trampolines(window);
+}
+
+inline void enable_joystick_events(bool enabled = true) {
+	detail::callbacks::buffer_joystick_events = enabled;
+	detail::callbacks::update_joystick_trampoline();
+}
+}
+
+/* Render threads owned by the window: destroying the window (raw handles through destroy_window) stops and joins its
+ * thread before the window goes away */
+namespace render_threads {
+template<class FrameFunction>
+inline void start(GLFWwindow* window, FrameFunction&& frame) {
+	static_assert(std::is_invocable_v<FrameFunction, window_ref>);
+	//replacing joins the running thread, which cannot join itself
+	if (detail::current_render_thread && detail::current_render_thread->window() == window) throw std::logic_error("render_threads::start called from the window's own render thread");
+	auto& cb = detail::callbacks::acquire(window);
+	cb.render.reset();
+	cb.render = std::make_unique<render_thread>(window, std::forward<FrameFunction>(frame));
+}
+
+/* from the window's own frame function it only requests the stop, the thread is joined by the next stop from another thread,
+ * a new start or the window's destruction */
+inline void stop(GLFWwindow* window) {
+	if (detail::current_render_thread && detail::current_render_thread->window() == window) {
+		detail::current_render_thread->stop();
+		return;
+	}
+	if (auto cb = detail::callbacks::find(window)) cb->render.reset();
+}
+
+inline bool is_running(GLFWwindow* window) {
+	auto cb = detail::callbacks::find(window);
+	return cb && cb->render && cb->render->running();
+}
+
+inline uint64_t frames(GLFWwindow* window) {
+	auto cb = detail::callbacks::find(window);
+	return cb && cb->render ? cb->render->frames() : 0;
+}
+}
+
+/* Cached window state: the focus, minimize, maximize and cursor enter trampolines mirror the window state into its
+ * callback block, so has_focus, is_minimized, is_maximized and is_hovered become plain loads; is_visible follows
+ * window::show / hide. Not tracked: visibility changed outside the wrapper (glfwShowWindow / glfwHideWindow), slots owned
+ * by a static handler, and every other attribute getter (is_resizable, is_decorated, is_floating, ...), which still asks GLFW.
+ * Raw handles: see destroy_window. */
+namespace cached_state {
+inline void enable(GLFWwindow* window) {
+	auto& cb = detail::callbacks::acquire(window);
+	if (!cb.state_cache) {
+		cb.state_cache = detail::callbacks::cached_window_state{
+			glfwGetWindowAttrib(window, GLFW_FOCUSED) == GLFW_TRUE,
+			glfwGetWindowAttrib(window, GLFW_ICONIFIED) == GLFW_TRUE,
+			glfwGetWindowAttrib(window, GLFW_MAXIMIZED) == GLFW_TRUE,
+			glfwGetWindowAttrib(window, GLFW_HOVERED) == GLFW_TRUE,
+			glfwGetWindowAttrib(window, GLFW_VISIBLE) == GLFW_TRUE,
+		};
+	}
+	detail::callbacks::update_trampolines(window);
+}
+
+inline void disable(GLFWwindow* window) {
+	detail::callbacks::acquire(window).state_cache.reset();
+	detail::callbacks::update_trampolines(window);
+}
+
+inline bool is_enabled(GLFWwindow* window) {
+	auto cb = detail::callbacks::find(window);
+	return cb && cb->state_cache;
+}
+}
+
+/* Cached window geometry: position, size, framebuffer size, frame and content scale are mirrored from the window event
+ * trampolines, so the window getters stop calling into GLFW. Values follow the events, a set_size or set_position shows
+ * up once the platform reports it, like the GLFW getters on most platforms. generation changes with every value change,
+ * layout code can compare it against the last one seen and skip work when nothing moved. Not tracked: values whose event
+ * slot is owned by a static handler, these stay at what they were when the handler took the slot over.
+ * Raw handles: see destroy_window. */
+namespace cached_geometry {
+inline void enable(GLFWwindow* window) {
+	auto& cb = detail::callbacks::acquire(window);
+	if (!cb.geometry_cache) {
+		window_geometry geometry{};
+		glfwGetWindowPos(window, &geometry.position.x, &geometry.position.y);
+		glfwGetWindowSize(window, &geometry.size.width, &geometry.size.height);
+		glfwGetFramebufferSize(window, &geometry.framebuffer.width, &geometry.framebuffer.height);
+		glfwGetWindowFrameSize(window, &geometry.frame.left, &geometry.frame.top, &geometry.frame.right, &geometry.frame.bottom);
+		glfwGetWindowContentScale(window, &geometry.scale.xScale, &geometry.scale.yScale);
+		geometry.generation = 1;
+		cb.geometry_cache = geometry;
+	}
+	detail::callbacks::update_trampolines(window);
+}
+
+inline void disable(GLFWwindow* window) {
+	detail::callbacks::acquire(window).geometry_cache.reset();
+	detail::callbacks::update_trampolines(window);
+}
+
+inline bool is_enabled(GLFWwindow* window) { return detail::find_geometry(window) != nullptr; }
+
+/* 0 while the cache is disabled */
+inline uint64_t generation(GLFWwindow* window) {
+	auto geometry = detail::find_geometry(window);
+	return geometry ? geometry->generation : 0;
+}
+
+inline std::optional<window_geometry> get(GLFWwindow* window) {
+	auto geometry = detail::find_geometry(window);
+	if (!geometry) return std::nullopt;
+	return *geometry;
+}
+}
+
+namespace detail {
+inline window_geometry const* find_geometry(GLFWwindow* window) {
+	auto cb = callbacks::find(window);
+	return cb && cb->geometry_cache ? &*cb->geometry_cache : nullptr;
+}
+
+inline bool get_attribute(GLFWwindow* window, int attribute) {
+	auto cb = callbacks::find(window);
+	if (cb && cb->state_cache) {
+		switch (attribute) {
+		case GLFW_FOCUSED: return cb->state_cache->focused;
+		case GLFW_ICONIFIED: return cb->state_cache->minimized;
+		case GLFW_MAXIMIZED: return cb->state_cache->maximized;
+		case GLFW_HOVERED: return cb->state_cache->hovered;
+		case GLFW_VISIBLE: return cb->state_cache->visible;
+		default: break;
+		}
+	}
+	return glfwGetWindowAttrib(window, attribute) == GLFW_TRUE;
+}
+
+inline void set_visible(GLFWwindow* window, bool visible) {
+	if (visible) glfwShowWindow(window);
+	else glfwHideWindow(window);
+	auto cb = callbacks::find(window);
+	if (cb && cb->state_cache) cb->state_cache->visible = visible;
+}
+}
+
+/* Synthetic events: calls the callback GLFW has installed for the window, exactly as a real event would,
+ * so callbacks, buffering, coalescing, input state and static handlers all see it. Injected events are timestamped on injection.
+ * Together with platform_type::Null this drives the event handling without a display. */
+namespace inject {
+namespace detail {
+/* GLFW only exposes the installed callback through its setter */
+template<class Callback>
+inline Callback installed(Callback (*setter)(GLFWwindow*, Callback), GLFWwindow* window) {
+	Callback callback = setter(window, nullptr);
+	setter(window, callback);
+	return callback;
+}
+}
+
+inline void key(GLFWwindow* window, glfw::key key, key_action action, modifier_flags modifiers = modifier_flags{ 0 }, int scanCode = 0) {
+	if (auto callback = detail::installed(&glfwSetKeyCallback, window)) callback(window, static_cast<int>(key), scanCode, static_cast<int>(action), static_cast<int>(modifiers));
+}
+inline void character(GLFWwindow* window, uint32_t codepoint) {
+	if (auto callback = detail::installed(&glfwSetCharCallback, window)) callback(window, codepoint);
+}
+inline void cursor(GLFWwindow* window, cursor_position position) {
+	if (auto callback = detail::installed(&glfwSetCursorPosCallback, window)) callback(window, position.x, position.y);
+}
+inline void cursor_enter(GLFWwindow* window, bool entered) {
+	if (auto callback = detail::installed(&glfwSetCursorEnterCallback, window)) callback(window, entered ? GLFW_TRUE : GLFW_FALSE);
+}
+inline void mouse_button(GLFWwindow* window, glfw::mouse_button button, mouse_button_action action, modifier_flags modifiers = modifier_flags{ 0 }) {
+	if (auto callback = detail::installed(&glfwSetMouseButtonCallback, window)) callback(window, static_cast<int>(button), static_cast<int>(action), static_cast<int>(modifiers));
+}
+inline void scroll(GLFWwindow* window, mouse_scroll_offset offset) {
+	if (auto callback = detail::installed(&glfwSetScrollCallback, window)) callback(window, offset.xOffset, offset.yOffset);
+}
+inline void drop(GLFWwindow* window, int count, char const** paths) {
+	if (auto callback = detail::installed(&glfwSetDropCallback, window)) callback(window, count, paths);
+}
+inline void drop(GLFWwindow* window, std::initializer_list<char const*> paths) {
+	std::vector<char const*> pathList{ paths };
+	drop(window, static_cast<int>(pathList.size()), pathList.data());
+}
+
+inline void position(GLFWwindow* window, window_position position) {
+	if (auto callback = detail::installed(&glfwSetWindowPosCallback, window)) callback(window, position.x, position.y);
+}
+inline void resize(GLFWwindow* window, window_size size) {
+	if (auto callback = detail::installed(&glfwSetWindowSizeCallback, window)) callback(window, size.width, size.height);
+}
+inline void framebuffer_resize(GLFWwindow* window, framebuffer_size size) {
+	if (auto callback = detail::installed(&glfwSetFramebufferSizeCallback, window)) callback(window, size.width, size.height);
+}
+inline void content_scale(GLFWwindow* window, window_content_scale scale) {
+	if (auto callback = detail::installed(&glfwSetWindowContentScaleCallback, window)) callback(window, scale.xScale, scale.yScale);
+}
+inline void focus(GLFWwindow* window, bool focused) {
+	if (auto callback = detail::installed(&glfwSetWindowFocusCallback, window)) callback(window, focused ? GLFW_TRUE : GLFW_FALSE);
+}
+inline void minimize(GLFWwindow* window, bool minimized) {
+	if (auto callback = detail::installed(&glfwSetWindowIconifyCallback, window)) callback(window, minimized ? GLFW_TRUE : GLFW_FALSE);
+}
+inline void maximize(GLFWwindow* window, bool maximized) {
+	if (auto callback = detail::installed(&glfwSetWindowMaximizeCallback, window)) callback(window, maximized ? GLFW_TRUE : GLFW_FALSE);
+}
+inline void refresh(GLFWwindow* window) {
+	if (auto callback = detail::installed(&glfwSetWindowRefreshCallback, window)) callback(window);
+}
+inline void close(GLFWwindow* window) {
+	if (auto callback = detail::installed(&glfwSetWindowCloseCallback, window)) callback(window);
+}
+
+/* the joystick callback is global and only ever the wrapper's trampoline, which checks whether it is needed */
+inline void joystick(joystick_id joystick, joystick_state state) {
+	glfw::detail::callbacks::glfw_joystick_callback(static_cast<int>(joystick), static_cast<int>(state));
+}
+}
+
+/* Static handlers: Derived implements any subset of
+ *	on_key(key_event), on_char(char_event), on_cursor(cursor_event), on_cursor_enter(cursor_enter_event),
+ *	on_mouse_button(mouse_button_event), on_scroll(mouse_scroll_event), on_drop(drop_event),
+ *	on_position(window_ref, window_position), on_resize(window_ref, window_size), on_framebuffer_resize(window_ref, framebuffer_size),
+ *	on_content_scale(window_ref, window_content_scale), on_focus(window_ref, bool), on_minimize(window_ref, bool),
+ *	on_maximize(window_ref, bool), on_refresh(window_ref), on_close(window_ref)
+ * install() picks the implemented members at compile time and installs only their trampolines, which call straight into Derived.
+ * The handler owns these GLFW callback slots until uninstall(): callbacks, buffering, coalescing and input state tracking registered for them are bypassed.
+ * The handler object has to outlive its installation. Installing on a raw handle attaches a callback block, see destroy_window. */
+namespace detail::handlers {
+template<class AlwaysVoid, template<class...> class Op, class ...Args>
+struct detector : std::false_type {};
+
+template<template<class...> class Op, class ...Args>
+struct detector<std::void_t<Op<Args...>>, Op, Args...> : std::true_type {};
+
+template<template<class...> class Op, class ...Args>
+inline constexpr bool is_detected_v = detector<void, Op, Args...>::value;
+
+template<class T> using on_key_t = decltype(std::declval<T&>().on_key(std::declval<key_event>()));
+template<class T> using on_char_t = decltype(std::declval<T&>().on_char(std::declval<char_event>()));
+template<class T> using on_cursor_t = decltype(std::declval<T&>().on_cursor(std::declval<cursor_event>()));
+template<class T> using on_cursor_enter_t = decltype(std::declval<T&>().on_cursor_enter(std::declval<cursor_enter_event>()));
+template<class T> using on_mouse_button_t = decltype(std::declval<T&>().on_mouse_button(std::declval<mouse_button_event>()));
+template<class T> using on_scroll_t = decltype(std::declval<T&>().on_scroll(std::declval<mouse_scroll_event>()));
+template<class T> using on_drop_t = decltype(std::declval<T&>().on_drop(std::declval<drop_event>()));
+template<class T> using on_position_t = decltype(std::declval<T&>().on_position(std::declval<window_ref>(), std::declval<window_position>()));
+template<class T> using on_resize_t = decltype(std::declval<T&>().on_resize(std::declval<window_ref>(), std::declval<window_size>()));
+template<class T> using on_framebuffer_resize_t = decltype(std::declval<T&>().on_framebuffer_resize(std::declval<window_ref>(), std::declval<framebuffer_size>()));
+template<class T> using on_content_scale_t = decltype(std::declval<T&>().on_content_scale(std::declval<window_ref>(), std::declval<window_content_scale>()));
+template<class T> using on_focus_t = decltype(std::declval<T&>().on_focus(std::declval<window_ref>(), std::declval<bool>()));
+template<class T> using on_minimize_t = decltype(std::declval<T&>().on_minimize(std::declval<window_ref>(), std::declval<bool>()));
+template<class T> using on_maximize_t = decltype(std::declval<T&>().on_maximize(std::declval<window_ref>(), std::declval<bool>()));
+template<class T> using on_refresh_t = decltype(std::declval<T&>().on_refresh(std::declval<window_ref>()));
+template<class T> using on_close_t = decltype(std::declval<T&>().on_close(std::declval<window_ref>()));
+}
+
+template<class Derived>
+class handler {
+public:
+	void install(GLFWwindow* window) {
+		using namespace detail::handlers;
+		using namespace detail::callbacks;
+		static_assert(std::is_base_of_v<handler, Derived>, "handler<Derived> has to be a base of Derived");
+		static_assert(installed_slots() != 0, "handler<Derived> requires at least one on_* member, see glfw::handler");
+
+		auto& cb = acquire(window);
+		cb.handler = static_cast<Derived*>(this);
+		cb.handler_slots = installed_slots();
+
+		if constexpr (is_detected_v<on_key_t, Derived>) glfwSetKeyCallback(window, &key_trampoline);
+		if constexpr (is_detected_v<on_char_t, Derived>) glfwSetCharCallback(window, &char_trampoline);
+		if constexpr (is_detected_v<on_cursor_t, Derived>) glfwSetCursorPosCallback(window, &cursor_trampoline);
+		if constexpr (is_detected_v<on_cursor_enter_t, Derived>) glfwSetCursorEnterCallback(window, &cursor_enter_trampoline);
+		if constexpr (is_detected_v<on_mouse_button_t, Derived>) glfwSetMouseButtonCallback(window, &mouse_button_trampoline);
+		if constexpr (is_detected_v<on_scroll_t, Derived>) glfwSetScrollCallback(window, &scroll_trampoline);
+		if constexpr (is_detected_v<on_drop_t, Derived>) glfwSetDropCallback(window, &drop_trampoline);
+		if constexpr (is_detected_v<on_position_t, Derived>) glfwSetWindowPosCallback(window, &position_trampoline);
+		if constexpr (is_detected_v<on_resize_t, Derived>) glfwSetWindowSizeCallback(window, &resize_trampoline);
+		if constexpr (is_detected_v<on_framebuffer_resize_t, Derived>) glfwSetFramebufferSizeCallback(window, &framebuffer_resize_trampoline);
+		if constexpr (is_detected_v<on_content_scale_t, Derived>) glfwSetWindowContentScaleCallback(window, &content_scale_trampoline);
+		if constexpr (is_detected_v<on_focus_t, Derived>) glfwSetWindowFocusCallback(window, &focus_trampoline);
+		if constexpr (is_detected_v<on_minimize_t, Derived>) glfwSetWindowIconifyCallback(window, &minimize_trampoline);
+		if constexpr (is_detected_v<on_maximize_t, Derived>) glfwSetWindowMaximizeCallback(window, &maximize_trampoline);
+		if constexpr (is_detected_v<on_refresh_t, Derived>) glfwSetWindowRefreshCallback(window, &refresh_trampoline);
+		if constexpr (is_detected_v<on_close_t, Derived>) glfwSetWindowCloseCallback(window, &close_trampoline);
+	}
+
+	/* gives the callback slots back to the regular callbacks of the window */
+	static void uninstall(GLFWwindow* window) {
+		auto& cb = detail::callbacks::acquire(window);
+		cb.handler = nullptr;
+		cb.handler_slots = 0;
+		detail::callbacks::update_trampolines(window);
+	}
+
+private:
+	static constexpr uint32_t installed_slots() {
+		using namespace detail::handlers;
+		using namespace detail::callbacks;
+		uint32_t slots = 0;
+		if (is_detected_v<on_key_t, Derived>) slots |= KEY_TRAMPOLINE;
+		if (is_detected_v<on_char_t, Derived>) slots |= CHAR_TRAMPOLINE;
+		if (is_detected_v<on_cursor_t, Derived>) slots |= CURSOR_TRAMPOLINE;
+		if (is_detected_v<on_cursor_enter_t, Derived>) slots |= CURSOR_ENTER_TRAMPOLINE;
+		if (is_detected_v<on_mouse_button_t, Derived>) slots |= MOUSE_BUTTON_TRAMPOLINE;
+		if (is_detected_v<on_scroll_t, Derived>) slots |= SCROLL_TRAMPOLINE;
+		if (is_detected_v<on_drop_t, Derived>) slots |= DROP_TRAMPOLINE;
+		if (is_detected_v<on_position_t, Derived>) slots |= POSITION_CHANGED;
+		if (is_detected_v<on_resize_t, Derived>) slots |= SIZE_CHANGED;
+		if (is_detected_v<on_framebuffer_resize_t, Derived>) slots |= FRAMEBUFFER_SIZE_CHANGED;
+		if (is_detected_v<on_content_scale_t, Derived>) slots |= CONTENT_SCALE_CHANGED;
+		if (is_detected_v<on_focus_t, Derived>) slots |= FOCUS_CHANGED;
+		if (is_detected_v<on_minimize_t, Derived>) slots |= MINIMIZE_STATE_CHANGED;
+		if (is_detected_v<on_maximize_t, Derived>) slots |= MAXIMIZE_STATE_CHANGED;
+		if (is_detected_v<on_refresh_t, Derived>) slots |= CONTENT_NEEDS_REFRESH;
+		if (is_detected_v<on_close_t, Derived>) slots |= CLOSE_REQUESTED;
+		return slots;
+	}
+
+	static Derived& self(GLFWwindow* window) { return *static_cast<Derived*>(detail::callbacks::find(window)->handler); }
+
+	static void key_trampoline(GLFWwindow* window, int key, int scanCode, int action, int modifiers) {
+		self(window).on_key(key_event{ window_ref{window}, glfw::key{key}, scanCode, key_action{action}, modifier_flags{modifiers}, glfwGetTimerValue() });
+	}
+	static void char_trampoline(GLFWwindow* window, uint32_t codepoint) { self(window).on_char(char_event{ window_ref{window}, code_point{codepoint}, glfwGetTimerValue() }); }
+	static void cursor_trampoline(GLFWwindow* window, double xpos, double ypos) { self(window).on_cursor(cursor_event{ window_ref{window}, cursor_position{xpos, ypos}, glfwGetTimerValue() }); }
+	static void cursor_enter_trampoline(GLFWwindow* window, int entered) { self(window).on_cursor_enter(cursor_enter_event{ window_ref{window}, entered == GLFW_TRUE, glfwGetTimerValue() }); }
+	static void mouse_button_trampoline(GLFWwindow* window, int button, int action, int modifiers) {
+		self(window).on_mouse_button(mouse_button_event{ window_ref{window}, mouse_button{button}, mouse_button_action{action}, modifier_flags{modifiers}, glfwGetTimerValue() });
+	}
+	static void scroll_trampoline(GLFWwindow* window, double xOffset, double yOffset) { self(window).on_scroll(mouse_scroll_event{ window_ref{window}, mouse_scroll_offset{xOffset, yOffset}, glfwGetTimerValue() }); }
+	static void drop_trampoline(GLFWwindow* window, int count, char const** paths) { self(window).on_drop(drop_event{ window_ref{window}, drop_paths{ paths, static_cast<size_t>(count) }, glfwGetTimerValue() }); }
+	static void position_trampoline(GLFWwindow* window, int x, int y) { self(window).on_position(window_ref{window}, window_position{x, y}); }
+	static void resize_trampoline(GLFWwindow* window, int width, int height) { self(window).on_resize(window_ref{window}, window_size{width, height}); }
+	static void framebuffer_resize_trampoline(GLFWwindow* window, int width, int height) { self(window).on_framebuffer_resize(window_ref{window}, framebuffer_size{width, height}); }
+	static void content_scale_trampoline(GLFWwindow* window, float xScale, float yScale) { self(window).on_content_scale(window_ref{window}, window_content_scale{xScale, yScale}); }
+	static void focus_trampoline(GLFWwindow* window, int focused) { self(window).on_focus(window_ref{window}, focused == GLFW_TRUE); }
+	static void minimize_trampoline(GLFWwindow* window, int minimized) { self(window).on_minimize(window_ref{window}, minimized == GLFW_TRUE); }
+	static void maximize_trampoline(GLFWwindow* window, int maximized) { self(window).on_maximize(window_ref{window}, maximized == GLFW_TRUE); }
+	static void refresh_trampoline(GLFWwindow* window) { self(window).on_refresh(window_ref{window}); }
+	static void close_trampoline(GLFWwindow* window) { self(window).on_close(window_ref{window}); }
+};
+
+/* Instrumentation queries */
+
+#ifdef GLFWHPP_INSTRUMENTATION
+struct metric_report {
+	/* nullptr for metric::Pump */
+	GLFWwindow* window;
+	metric type;
+	histogram_summary summary;
+};
+
+namespace detail {
+inline inplace_function<void(metric_report const&)> dump_callback;
+inline uint64_t dump_interval = 0;
+inline uint64_t next_dump = 0;
+
+inline latency_histogram* find_histogram(GLFWwindow* window, metric metric) {
+	if (metric == metric::Pump) return &pump_histogram;
+	auto cb = window ? callbacks::find(window) : nullptr;
+	if (!cb) return nullptr;
+	switch (metric) {
+	case metric::Frame: return &cb->metrics.frame;
+	case metric::Swap: return &cb->metrics.swap;
+	default: return &cb->metrics.callback;
+	}
+}
+
+inline void periodic_dump() {
+	if (!dump_callback) return;
+	uint64_t now = glfwGetTimerValue();
+	if (now < next_dump) return;
+	next_dump = now + dump_interval;
+
+	dump_callback(metric_report{ nullptr, metric::Pump, pump_histogram.summary() });
+	for (auto& cb : callbacks::window_slots) {
+		if (!cb || !cb->owned) continue;
+		dump_callback(metric_report{ cb->handle, metric::Frame, cb->metrics.frame.summary() });
+		dump_callback(metric_report{ cb->handle, metric::Swap, cb->metrics.swap.summary() });
+		dump_callback(metric_report{ cb->handle, metric::Callback, cb->metrics.callback.summary() });
+	}
+}
+}
+
+namespace instrumentation {
+/* window is ignored for metric::Pump */
+inline histogram_summary summary(GLFWwindow* window, metric metric) {
+	auto histogram = detail::find_histogram(window, metric);
+	return histogram ? histogram->summary() : histogram_summary{};
+}
+inline histogram_summary pump_summary() { return detail::pump_histogram.summary(); }
+
+inline void reset(GLFWwindow* window, metric metric) {
+	if (auto histogram = detail::find_histogram(window, metric)) histogram->reset();
+}
+
+/* calls the callback with the summary of every metric from poll_events / wait_events, at most once per interval */
+template<class DumpCallback>
+inline void set_periodic_dump(double intervalSeconds, DumpCallback&& callback) {
+	static_assert(std::is_invocable_v<DumpCallback, metric_report const&>);
+	detail::dump_callback = std::forward<DumpCallback>(callback);
+	detail::dump_interval = static_cast<uint64_t>(intervalSeconds * static_cast<double>(glfwGetTimerFrequency()));
+	detail::next_dump = glfwGetTimerValue() + detail::dump_interval;
+}
+
+inline void set_periodic_dump(std::nullptr_t) { detail::dump_callback = nullptr; }
+}
+#endif
+
+namespace detail {
+inline void swap_buffers(GLFWwindow* window) {
+#ifdef GLFWHPP_INSTRUMENTATION
+	if (auto cb = callbacks::find(window)) {
+		{
+			scoped_sample sample{ cb->metrics.swap };
+			glfwSwapBuffers(window);
+		}
+		uint64_t now = glfwGetTimerValue();
+		uint64_t last = cb->metrics.last_swap.exchange(now, std::memory_order_relaxed);
+		if (last) cb->metrics.frame.record(static_cast<uint64_t>(ticks().to_ns(now - last)));
+		return;
+	}
+#endif
+	glfwSwapBuffers(window);
+}
+}
+
+/************************************************************************************
+ *																					*
+ *									RECORD & REPLAY									*
+ *																					*
+ ************************************************************************************/
+
+/* Opt-in with GLFWHPP_RECORD_REPLAY.
+ * input_recorder writes every event entering the callback trampolines to an append-only file, input_player maps such a file
+ * and feeds the events back through the same trampolines, so buffering, coalescing and input state behave as recorded.
+ * The file uses native endianness: a recording_header, then records, each followed by payload_size bytes padded to 8.
+ * Drop records carry their NUL-terminated paths as payload. */
+#ifdef GLFWHPP_RECORD_REPLAY
+enum class record_kind : uint32_t {
+	Event,
+	/* end of a poll_events / wait_events call */
+	PollEnd,
+};
+
+struct recording_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t record_size;
+	uint64_t timer_frequency;
+};
+
+struct record_header {
+	record_kind kind;
+	uint32_t payload_size;
+	event e;
+};
+static_assert(std::is_trivially_copyable_v<record_header>);
+
+namespace detail {
+inline constexpr char RECORDING_MAGIC[8] = { 'G', 'L', 'F', 'W', 'R', 'E', 'C', '\0' };
+inline constexpr uint32_t RECORDING_VERSION = 2;
+
+inline constexpr size_t record_padding(size_t size) { return (8 - size % 8) % 8; }
+}
+
+/* Only one recorder is active at a time. Windows created while recording are recorded from their creation, raw handles
+ * from their first use with the wrapper. */
+class input_recorder {
+public:
+	explicit input_recorder(char const* path) : m_file(std::fopen(path, "wb")) {
+		if (!m_file) throw std::runtime_error("Failed to open input recording");
+		recording_header header{ {}, detail::RECORDING_VERSION, sizeof(record_header), glfwGetTimerFrequency() };
+		std::memcpy(header.magic, detail::RECORDING_MAGIC, sizeof(header.magic));
+		write(&header, sizeof(header));
+	}
+	~input_recorder() {
+		stop();
+		flush();
+		std::fclose(m_file);
+	}
+
+	input_recorder(input_recorder const&) = delete;
+	input_recorder& operator=(input_recorder const&) = delete;
+
+	inline void start();
+	inline void stop();
+	inline bool recording() const;
+
+	size_t size() const { return m_records; }
+
+	void flush() {
+		if (!m_buffer.empty()) std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+		m_buffer.clear();
+		std::fflush(m_file);
+	}
+
+	void append(record_kind kind, event const& e, char const* const* paths = nullptr) {
+		uint32_t payloadSize = 0;
+		if (paths) for (uint32_t i = 0; i < e.drop.count; ++i) payloadSize += static_cast<uint32_t>(std::strlen(paths[i]) + 1);
+
+		record_header record{ kind, payloadSize, e };
+		write(&record, sizeof(record));
+		if (paths) for (uint32_t i = 0; i < e.drop.count; ++i) write(paths[i], std::strlen(paths[i]) + 1);
+		static constexpr char padding[8] = {};
+		write(padding, detail::record_padding(payloadSize));
+		++m_records;
+	}
+
+private:
+	static constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+	void write(void const* data, size_t size) {
+		auto bytes = static_cast<char const*>(data);
+		m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+		if (m_buffer.size() >= FLUSH_SIZE) {
+			std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+			m_buffer.clear();
+		}
+	}
+
+	std::FILE* m_file;
+	std::vector<char> m_buffer;
+	size_t m_records = 0;
+};
+
+enum class replay_mode : uint8_t {
+	/* events are injected once their recorded time since the first event has passed */
+	RealTime,
+	/* each poll injects the events of one recorded poll */
+	AsFastAsPossible,
+};
+
+/* Plays a recording back, attached players inject from poll_events / wait_events.
+ * Recorded window ids are matched by their slot, ignoring the generation: slots of the recording session match when windows
+ * are created in the same order; map_window overrides them. */
+class input_player {
+public:
+	explicit input_player(char const* path) {
+		map_file(path);
+		recording_header header;
+		if (m_size < sizeof(header)) throw std::runtime_error("Invalid input recording");
+		std::memcpy(&header, m_data, sizeof(header));
+		if (std::memcmp(header.magic, detail::RECORDING_MAGIC, sizeof(header.magic)) != 0 || header.version != detail::RECORDING_VERSION || header.record_size != sizeof(record_header))
+			throw std::runtime_error("Invalid input recording");
+		m_conversion = detail::tick_conversion{ header.timer_frequency };
+		rewind();
+	}
+	~input_player() {
+		detach();
+		unmap_file();
+	}
+
+	input_player(input_player const&) = delete;
+	input_player& operator=(input_player const&) = delete;
+
+	void map_window(uint32_t recordedId, GLFWwindow* window) {
+		uint32_t slot = recordedId & detail::callbacks::WINDOW_SLOT_MASK;
+		if (slot >= m_windows.size()) m_windows.resize(slot + 1, nullptr);
+		m_windows[slot] = window;
+	}
+
+	inline void attach(replay_mode mode);
+	inline void detach();
+
+	bool done() const { return m_offset >= m_size; }
+	void rewind() {
+		m_offset = sizeof(recording_header);
+		m_start = 0;
+		m_first = 0;
+	}
+
+	/* injects the next event record, skipping poll markers, false at the end of the recording */
+	bool step() {
+		record_header record;
+		while (next(record)) {
+			if (record.kind == record_kind::Event) {
+				inject(record);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/* injects the events up to the end of the next recorded poll */
+	size_t play_poll() {
+		size_t injected = 0;
+		record_header record;
+		while (next(record) && record.kind != record_kind::PollEnd) {
+			inject(record);
+			++injected;
+		}
+		return injected;
+	}
+
+	/* injects every event recorded at most the elapsed time since the first call after the first event */
+	size_t play_due() {
+		uint64_t now = glfwGetTimerValue();
+		if (m_start == 0) m_start = now;
+		int64_t elapsed = detail::ticks().to_ns(now - m_start);
+
+		size_t injected = 0;
+		record_header record;
+		while (peek(record)) {
+			if (record.kind == record_kind::Event) {
+				if (m_first == 0) m_first = record.e.timestamp;
+				if (m_conversion.to_ns(record.e.timestamp - m_first) > elapsed) break;
+			}
+			next(record);
+			if (record.kind == record_kind::Event) {
+				inject(record);
+				++injected;
+			}
+		}
+		return injected;
+	}
+
+	size_t play_all() {
+		size_t injected = 0;
+		while (step()) ++injected;
+		return injected;
+	}
+
+	replay_mode mode() const { return m_mode; }
+
+private:
+	/* false at the end and for a truncated record, whose payload would reach past the recording */
+	bool peek(record_header& record) const {
+		if (m_offset + sizeof(record_header) > m_size) return false;
+		std::memcpy(&record, m_data + m_offset, sizeof(record));
+		return m_offset + sizeof(record_header) + record.payload_size <= m_size;
+	}
+
+	bool next(record_header& record) {
+		if (!peek(record)) {
+			m_offset = m_size;
+			return false;
+		}
+		m_payload = m_data + m_offset + sizeof(record_header);
+		m_offset += sizeof(record_header) + record.payload_size + detail::record_padding(record.payload_size);
+		return true;
+	}
+
+	GLFWwindow* window(uint32_t recordedId) const {
+		uint32_t slot = recordedId & detail::callbacks::WINDOW_SLOT_MASK;
+		if (slot < m_windows.size() && m_windows[slot]) return m_windows[slot];
+		return detail::callbacks::window_from_slot(slot);
+	}
+
+	void inject(record_header const& record) {
+		using namespace detail::callbacks;
+		auto const& e = record.e;
+		if (e.type == event_type::Joystick) {
+			glfw_joystick_callback(e.joystick.id, e.joystick.connected ? GLFW_CONNECTED : GLFW_DISCONNECTED);
+			return;
+		}
+		auto target = window(e.window_id);
+		if (!target) return;
+
+		switch (e.type) {
+		case event_type::Key: glfw_key_callback(target, e.key.key, e.key.scancode, e.key.action, e.key.modifiers); break;
+		case event_type::Char: glfw_char_callback(target, e.character.codepoint); break;
+		case event_type::Cursor: glfw_cursor_callback(target, e.cursor.x, e.cursor.y); break;
+		case event_type::CursorEnter: glfw_cursor_enter_callback(target, e.cursor_enter.entered ? GLFW_TRUE : GLFW_FALSE); break;
+		case event_type::MouseButton: glfw_mouse_button_callback(target, e.mouse_button.button, e.mouse_button.action, e.mouse_button.modifiers); break;
+		case event_type::MouseScroll: glfw_mouse_scroll_callback(target, e.scroll.xOffset, e.scroll.yOffset); break;
+		case event_type::Drop: {
+			m_paths.clear();
+			for (uint32_t i = 0, offset = 0; i < e.drop.count && offset < record.payload_size; ++i) {
+				char const* path = m_payload + offset;
+				auto terminator = static_cast<char const*>(std::memchr(path, '\0', record.payload_size - offset));
+				if (!terminator) break; //unterminated path, the payload is corrupt
+				m_paths.push_back(path);
+				offset += static_cast<uint32_t>(terminator - path + 1);
+			}
+			glfw_drop_callback(target, static_cast<int>(m_paths.size()), m_paths.data());
+			break;
+		}
+		case event_type::Window: inject_window_event(target, e.window); break;
+		default: break;
+		}
+	}
+
+	static void inject_window_event(GLFWwindow* target, event::window_data const& data) {
+		using namespace detail::callbacks;
+		auto state = data.state ? GLFW_TRUE : GLFW_FALSE;
+		switch (data.type) {
+		case POSITION_CHANGED: glfw_window_pos_callback(target, data.position.x, data.position.y); break;
+		case SIZE_CHANGED: glfw_window_size_callback(target, data.size.width, data.size.height); break;
+		case FRAMEBUFFER_SIZE_CHANGED: glfw_framebuffer_size_callback(target, data.framebuffer.width, data.framebuffer.height); break;
+		case CONTENT_SCALE_CHANGED: glfw_window_content_scale_callback(target, data.scale.xScale, data.scale.yScale); break;
+		case FOCUS_CHANGED: glfw_window_focus_callback(target, state); break;
+		case MINIMIZE_STATE_CHANGED: glfw_window_minimize_callback(target, state); break;
+		case MAXIMIZE_STATE_CHANGED: glfw_window_maximize_callback(target, state); break;
+		case CONTENT_NEEDS_REFRESH: glfw_window_refresh_callback(target); break;
+		case CLOSE_REQUESTED: glfw_window_close_callback(target); break;
+		default: break;
+		}
+	}
+
+#if defined(__unix__) || defined(__APPLE__)
+	void map_file(char const* path) {
+		int fd = ::open(path, O_RDONLY);
+		if (fd < 0) throw std::runtime_error("Failed to open input recording");
+		struct stat info;
+		if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+			::close(fd);
+			throw std::runtime_error("Invalid input recording");
+		}
+		m_size = static_cast<size_t>(info.st_size);
+		void* mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (mapping == MAP_FAILED) throw std::runtime_error("Failed to map input recording");
+		m_data = static_cast<char const*>(mapping);
+	}
+	void unmap_file() { ::munmap(const_cast<char*>(m_data), m_size); }
+#else
+	//no mapping without platform headers, the recording is read at once
+	void map_file(char const* path) {
+		std::FILE* file = std::fopen(path, "rb");
+		if (!file) throw std::runtime_error("Failed to open input recording");
+		std::fseek(file, 0, SEEK_END);
+		m_size = static_cast<size_t>(std::ftell(file));
+		std::fseek(file, 0, SEEK_SET);
+		m_contents = std::make_unique<char[]>(m_size);
+		m_size = std::fread(m_contents.get(), 1, m_size, file);
+		std::fclose(file);
+		m_data = m_contents.get();
+	}
+	void unmap_file() {}
+
+	std::unique_ptr<char[]> m_contents;
+#endif
+
+	char const* m_data = nullptr;
+	size_t m_size = 0;
+	size_t m_offset = 0;
+	char const* m_payload = nullptr;
+	detail::tick_conversion m_conversion{ 1 };
+	uint64_t m_start = 0;
+	uint64_t m_first = 0;
+	replay_mode m_mode = replay_mode::RealTime;
+	std::vector<GLFWwindow*> m_windows;
+	std::vector<char const*> m_paths;
+};
+
+namespace detail {
+inline input_recorder* active_recorder = nullptr;
+inline input_player* active_player = nullptr;
+
+inline void callbacks::record(event const& e, char const* const* paths) {
+	if (active_recorder) active_recorder->append(record_kind::Event, e, paths);
+}
+
+inline void record_poll_end() {
+	if (active_recorder) active_recorder->append(record_kind::PollEnd, event{});
+}
+
+inline void replay_poll() {
+	if (!active_player) return;
+	if (active_player->mode() == replay_mode::RealTime) active_player->play_due();
+	else active_player->play_poll();
+}
+
+inline void set_recording(bool enabled) {
+	callbacks::recording_input = enabled;
+	//raw handles may already be destroyed, they pick the recording up with their next callback change
+	for (auto& cb : callbacks::window_slots) if (cb && cb->owned) callbacks::update_trampolines(cb->handle);
+	callbacks::update_joystick_trampoline();
+}
+}
+
+inline void input_recorder::start() {
+	if (detail::active_recorder && detail::active_recorder != this) detail::active_recorder->stop();
+	detail::active_recorder = this;
+	detail::set_recording(true);
+}
+
+inline void input_recorder::stop() {
+	if (detail::active_recorder != this) return;
+	detail::active_recorder = nullptr;
+	detail::set_recording(false);
+	flush();
+}
+
+inline bool input_recorder::recording() const { return detail::active_recorder == this; }
+
+inline void input_player::attach(replay_mode mode) {
+	m_mode = mode;
+	detail::active_player = this;
+}
+
+inline void input_player::detach() {
+	if (detail::active_player == this) detail::active_player = nullptr;
+}
+#endif
+
+/* Events */
+
+namespace detail {
+#ifdef GLFWHPP_COROUTINES
+inline void resume_coroutines();
+#endif
+
+template<class Pump>
+inline event_batch pump_events(Pump&& pump) {
+	thread_events.begin_batch();
+	callbacks::begin_input_frame();
+	{
+#ifdef GLFWHPP_INSTRUMENTATION
+		scoped_sample sample{ pump_histogram };
+#endif
+		pump();
+	}
+	if (auto queue = main_thread_queue_instance.load(std::memory_order_acquire)) queue->drain();
+#ifdef GLFWHPP_RECORD_REPLAY
+	replay_poll();
+	record_poll_end();
+#endif
+	callbacks::flush_coalesced();
+#ifdef GLFWHPP_COROUTINES
+	resume_coroutines();
+#endif
+#ifdef GLFWHPP_INSTRUMENTATION
+	periodic_dump();
+#endif
+	return thread_events.end_batch();
+}
+}
+
+inline event_batch poll_events() {
+	return detail::pump_events([] { glfwPollEvents(); });
+}
+
+inline event_batch wait_events() {
+	return detail::pump_events([] { glfwWaitEvents(); });
+}
+
+inline event_batch wait_events(double timeout) {
+	return detail::pump_events([timeout] { glfwWaitEventsTimeout(timeout); });
+}
+
+#ifdef GLFWHPP_COROUTINES
+/************************************************************************************
+ *																					*
+ *									 COROUTINES										*
+ *																					*
+ ************************************************************************************/
+
+namespace detail {
+/* Size-classed free lists for coroutine frames, a finished task hands its block to the next one of similar size */
+class coroutine_frame_pool {
+public:
+	static constexpr size_t GRANULE = 64;
+	static constexpr size_t CLASSES = 32;
+
+	coroutine_frame_pool() = default;
+	coroutine_frame_pool(coroutine_frame_pool const&) = delete;
+	coroutine_frame_pool& operator=(coroutine_frame_pool const&) = delete;
+
+	~coroutine_frame_pool() {
+		for (auto block : m_free) {
+			while (block) ::operator delete(std::exchange(block, block->next));
+		}
+	}
+
+	void* allocate(size_t size) {
+		size_t index = (size - 1) / GRANULE;
+		if (index >= CLASSES) return ::operator new(size);
+		if (auto block = m_free[index]) {
+			m_free[index] = block->next;
+			return block;
+		}
+		return ::operator new((index + 1) * GRANULE);
+	}
+
+	void deallocate(void* memory, size_t size) noexcept {
+		size_t index = (size - 1) / GRANULE;
+		if (index >= CLASSES) {
+			::operator delete(memory);
+			return;
+		}
+		auto block = static_cast<free_block*>(memory);
+		block->next = m_free[index];
+		m_free[index] = block;
+	}
+
+private:
+	struct free_block {
+		free_block* next;
+	};
+	std::array<free_block*, CLASSES> m_free{};
+};
+
+inline thread_local coroutine_frame_pool coroutine_frames;
+
+struct timer_waiter {
+	clock::time_point deadline;
+	std::coroutine_handle<> handle;
+};
+
+inline bool later_deadline(timer_waiter const& a, timer_waiter const& b) { return a.deadline > b.deadline; }
+
+/* next_frame waiters swap with the resume list every poll, both keep their capacity; timers form a min-heap */
+inline thread_local std::vector<std::coroutine_handle<>> frame_waiters;
+inline thread_local std::vector<std::coroutine_handle<>> resuming_frame_waiters;
+inline thread_local std::vector<timer_waiter> timer_waiters;
+
+inline void resume_coroutines() {
+	if (!frame_waiters.empty()) {
+		resuming_frame_waiters.swap(frame_waiters);
+		for (auto handle : resuming_frame_waiters) handle.resume();
+		resuming_frame_waiters.clear();
+	}
+	if (timer_waiters.empty()) return;
+	auto now = clock::now();
+	while (!timer_waiters.empty() && timer_waiters.front().deadline <= now) {
+		std::pop_heap(timer_waiters.begin(), timer_waiters.end(), &later_deadline);
+		auto handle = timer_waiters.back().handle;
+		timer_waiters.pop_back();
+		handle.resume();
+	}
+}
+}
+
+/* Coroutines driven by the event pump: input awaitables resume inside the trampoline of the event, next_frame and timeout
+ * at the end of poll_events / wait_events, all on the polling thread. Suspending never allocates, the awaiter lives in the
+ * coroutine frame and frames are pooled per thread. Tasks must not call poll_events / wait_events themselves.
+ *	glfw::async::task confirm(glfw::window_ref window) {
+ *		auto click = co_await glfw::async::next_mouse_button(window);
+ *		auto key = co_await glfw::async::next_key(window);
+ *		co_await glfw::async::timeout(std::chrono::milliseconds{ 500 });
+ *	}
+ * Awaiting input of a raw handle attaches a callback block, see destroy_window. */
+namespace async {
+/* Fire-and-forget coroutine, runs until its first suspension when called. Unhandled exceptions terminate. */
+class task {
+public:
+	struct promise_type {
+		task get_return_object() noexcept { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept { std::terminate(); }
+
+		static void* operator new(size_t size) { return detail::coroutine_frames.allocate(size); }
+		static void operator delete(void* memory, size_t size) noexcept { detail::coroutine_frames.deallocate(memory, size); }
+	};
+};
+
+template<class Event, auto Waiters>
+class event_awaitable {
+public:
+	explicit event_awaitable(GLFWwindow* window) : m_window(window) {}
+
+	bool await_ready() const noexcept { return false; }
+
+	void await_suspend(std::coroutine_handle<> handle) {
+		auto& cb = detail::callbacks::acquire(m_window);
+		if (!cb.awaited) {
+			cb.awaited = true;
+			detail::callbacks::update_trampolines(m_window);
+		}
+		m_waiter.handle = handle;
+		m_waiter.next = cb.*Waiters;
+		cb.*Waiters = &m_waiter;
+	}
+
+	Event await_resume() { return *m_waiter.event; }
+
+private:
+	GLFWwindow* m_window;
+	detail::callbacks::event_waiter<Event> m_waiter{};
+};
+
+inline auto next_key(GLFWwindow* window) {
+	return event_awaitable<key_event, &detail::callbacks::window_callbacks::key_waiters>{ window };
+}
+
+inline auto next_mouse_button(GLFWwindow* window) {
+	return event_awaitable<mouse_button_event, &detail::callbacks::window_callbacks::mouse_button_waiters>{ window };
+}
+
+/* resumes at the end of the next poll_events / wait_events */
+struct frame_awaitable {
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> handle) { detail::frame_waiters.push_back(handle); }
+	void await_resume() const noexcept {}
+};
+
+inline frame_awaitable next_frame() { return {}; }
+
+/* resumes at the end of the first poll_events / wait_events after the delay, see next_deadline */
+class timer_awaitable {
+public:
+	explicit timer_awaitable(clock::time_point deadline) : m_deadline(deadline) {}
+
+	bool await_ready() const { return m_deadline <= clock::now(); }
+
+	void await_suspend(std::coroutine_handle<> handle) {
+		detail::timer_waiters.push_back({ m_deadline, handle });
+		std::push_heap(detail::timer_waiters.begin(), detail::timer_waiters.end(), &detail::later_deadline);
+	}
+
+	void await_resume() const noexcept {}
+
+private:
+	clock::time_point m_deadline;
+};
+
+inline timer_awaitable timeout(clock::duration delay) { return timer_awaitable{ clock::now() + delay }; }
+
+/* earliest timeout deadline on this thread, for wait_events(timeout) loops */
+inline std::optional<clock::time_point> next_deadline() {
+	if (detail::timer_waiters.empty()) return std::nullopt;
+	return detail::timer_waiters.front().deadline;
+}
+}
+#endif
+
+#ifdef GLFWHPP_REACTOR
+/************************************************************************************
+ *																					*
+ *									  REACTOR										*
+ *																					*
+ ************************************************************************************/
+
+/* Running GLFW from an external epoll / poll reactor instead of wait_events:
+ *	register reactor::display_fd() and reactor::wake_fd() for reading
+ *	loop: bool queued = reactor::prepare();
+ *	      epoll_wait(..., queued ? 0 : reactor::timeout(ms));
+ *	      reactor::dispatch(); service the other fds
+ * prepare() reports events already read from the connection (Xlib queue, Wayland default queue), which leave the fd idle,
+ * so the wait must not block then. Every prepare() has to be followed by dispatch(): on Wayland prepare() takes the
+ * connection's read intent (wl_display_prepare_read), dispatch() completes or cancels it before GLFW polls.
+ * wake_fd becomes readable on every post_empty_event (main_thread::post included).
+ * GLFW keeps private fds that no API exposes and that are only serviced by polling: on Wayland the key repeat and cursor
+ * animation timerfds, on Linux the joystick hotplug inotify fd. timeout() bounds the wait while those matter. Without a
+ * display fd (other platforms, or neither GLFWHPP_REACTOR_X11 nor _WAYLAND) input is only seen by polling, keep a timeout then. */
+#ifndef GLFWHPP_REACTOR_POLL_INTERVAL_MS
+#define GLFWHPP_REACTOR_POLL_INTERVAL_MS 20
+#endif
+
+namespace detail {
+#ifdef GLFWHPP_REACTOR_X11
+inline ::_XDisplay* x11_display() {
+#ifdef GLFW_PLATFORM
+	if (glfwGetPlatform() != GLFW_PLATFORM_X11) return nullptr;
+#endif
+	return glfwGetX11Display();
+}
+#endif
+
+#ifdef GLFWHPP_REACTOR_WAYLAND
+inline ::wl_display* wayland_display() {
+#ifdef GLFW_PLATFORM
+	if (glfwGetPlatform() != GLFW_PLATFORM_WAYLAND) return nullptr;
+#endif
+	return glfwGetWaylandDisplay();
+}
+
+/* prepare() holds the read intent until dispatch() */
+inline bool wayland_reading = false;
+#endif
+}
+
+namespace reactor {
+/* connection fd of the X11 / Wayland display, -1 when unavailable */
+inline int display_fd() {
+#ifdef GLFWHPP_REACTOR_X11
+	if (auto display = detail::x11_display()) return XConnectionNumber(display);
+#endif
+#ifdef GLFWHPP_REACTOR_WAYLAND
+	if (auto display = detail::wayland_display()) return wl_display_get_fd(display);
+#endif
+	return -1;
+}
+
+/* eventfd signalled by post_empty_event, created by the first call, -1 if eventfd fails */
+inline int wake_fd() {
+	int fd = detail::wake_fd.fd.load(std::memory_order_acquire);
+	if (fd >= 0) return fd;
+	int created = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (created < 0) return -1;
+	if (!detail::wake_fd.fd.compare_exchange_strong(fd, created, std::memory_order_acq_rel)) {
+		::close(created);
+		return fd;
+	}
+	return created;
+}
+
+/* call right before blocking on the fds: sends requests still buffered in the display connection (replies to unflushed
+ * requests, e.g. after set_size, would otherwise never arrive) and returns true when events are already queued
+ * client side, the wait has to return immediately then */
+inline bool prepare() {
+#ifdef GLFWHPP_REACTOR_X11
+	if (auto display = detail::x11_display()) {
+		XFlush(display);
+		constexpr int QUEUED_ALREADY = 0;
+		return XEventsQueued(display, QUEUED_ALREADY) > 0;
+	}
+#endif
+#ifdef GLFWHPP_REACTOR_WAYLAND
+	if (auto display = detail::wayland_display()) {
+		if (detail::wayland_reading) return false;
+		//fails while the default queue holds events, GLFW dispatches them in dispatch()
+		if (wl_display_prepare_read(display) != 0) return true;
+		detail::wayland_reading = true;
+		while (wl_display_flush(display) < 0 && errno == EINTR) {}
+	}
+#endif
+	return false;
+}
+
+/* bounds a wait of requestedMs (-1 for none) while GLFW's private fds need polling: Wayland key repeat and cursor
+ * animation, joystick hotplug when a joystick callback is set */
+inline int timeout(int requestedMs) {
+	bool privateFds = detail::callbacks::joystick_callback || detail::callbacks::buffer_joystick_events;
+#ifdef GLFWHPP_REACTOR_WAYLAND
+	privateFds = privateFds || detail::wayland_display();
+#endif
+	if (!privateFds) return requestedMs;
+	return requestedMs < 0 ? GLFWHPP_REACTOR_POLL_INTERVAL_MS : std::min(requestedMs, GLFWHPP_REACTOR_POLL_INTERVAL_MS);
+}
+
+/* resets the wake fd, completes the read prepared by prepare() and polls, GLFW dispatches whatever was read */
+inline event_batch dispatch() {
+	int fd = detail::wake_fd.fd.load(std::memory_order_acquire);
+	if (fd >= 0) {
+		uint64_t count;
+		[[maybe_unused]] auto bytesRead = ::read(fd, &count, sizeof(count));
+	}
+#ifdef GLFWHPP_REACTOR_WAYLAND
+	if (detail::wayland_reading) {
+		detail::wayland_reading = false;
+		auto display = detail::wayland_display();
+		pollfd connection{ wl_display_get_fd(display), POLLIN, 0 };
+		if (::poll(&connection, 1, 0) > 0) wl_display_read_events(display);
+		else wl_display_cancel_read(display);
+	}
+#endif
+	return poll_events();
+}
+}
+#endif
+
+/************************************************************************************
+ *																					*
+ *									 FRAME PACING									*
+ *																					*
+ ************************************************************************************/
+
+/* all durations in seconds */
+struct frame_pacing_stats {
+	uint64_t frames = 0;
+	/* frames whose work alone exceeded the budget */
+	uint64_t missed = 0;
+	/* frames the pacer slept for, neither missed nor left to vsync */
+	uint64_t paced = 0;
+	/* budget left when wait() was called, negative for missed frames */
+	double last_slack = 0.0;
+	/* how late wait() returned past the deadline */
+	double last_overshoot = 0.0;
+	/* over the paced frames only */
+	double max_overshoot = 0.0;
+	double mean_overshoot = 0.0;
+	/* time spun on the timer before each deadline, calibrated from the observed sleep overshoot */
+	double spin_margin = 0.0;
+};
+
+/* Paces a frame loop to a target rate: call wait() once per frame.
+ * Sleeps coarsely until spin_margin before the deadline, then spins on glfwGetTimerValue.
+ * Deadlines advance by the budget, so jitter does not accumulate; after a missed frame the pacer resyncs to now.
+ * With vsync enabled through set_swap_interval the swap already paces at the refresh period, the pacer only limits
+ * when its budget is longer than that. */
+class frame_pacer {
+public:
+	explicit frame_pacer(double targetRate) : m_frequency(timer_frequency()) { set_target_rate(targetRate); }
+
+	static frame_pacer from_budget(double seconds) { return frame_pacer{ 1.0 / seconds }; }
+
+	void set_target_rate(double targetRate) { set_frame_budget(1.0 / targetRate); }
+	void set_frame_budget(double seconds) {
+		m_budget = to_ticks(seconds);
+		m_deadline = 0;
+	}
+	double frame_budget() const { return to_seconds(m_budget); }
+
+	/* forwards to glfw::set_swap_interval, refreshRate is the refresh rate of the monitor the window is on */
+	void set_swap_interval(int swapInterval, double refreshRate) {
+		glfw::set_swap_interval(swapInterval);
+		m_vsyncPeriod = swapInterval > 0 && refreshRate > 0.0 ? to_ticks(swapInterval / refreshRate) : 0;
+	}
+
+	void wait() {
+		uint64_t now = time_raw();
+		if (m_deadline == 0) m_deadline = now;
+		m_deadline += m_budget;
+
+		double slack = to_seconds(static_cast<int64_t>(m_deadline - now));
+		m_stats.last_slack = slack;
+		++m_stats.frames;
+
+		if (static_cast<int64_t>(m_deadline - now) <= 0) {
+			++m_stats.missed;
+			m_stats.last_overshoot = 0.0;
+			m_deadline = now;
+			return;
+		}
+
+		//the swap blocks until the next vblank, limiting to a shorter budget would only add latency
+		if (m_vsyncPeriod >= m_budget) {
+			m_stats.last_overshoot = 0.0;
+			m_deadline = now;
+			return;
+		}
+
+		sleep_until(m_deadline);
+		while (time_raw() < m_deadline) {}
+
+		double overshoot = to_seconds(static_cast<int64_t>(time_raw() - m_deadline));
+		m_stats.last_overshoot = overshoot;
+		if (overshoot > m_stats.max_overshoot) m_stats.max_overshoot = overshoot;
+		++m_stats.paced;
+		m_stats.mean_overshoot += (overshoot - m_stats.mean_overshoot) / static_cast<double>(m_stats.paced);
+	}
+
+	void reset() {
+		m_deadline = 0;
+		m_stats = frame_pacing_stats{ 0, 0, 0, 0.0, 0.0, 0.0, 0.0, m_stats.spin_margin };
+	}
+
+	frame_pacing_stats const& stats() const { return m_stats; }
+
+private:
+	static constexpr double MIN_SPIN_MARGIN = 0.0002;
+	static constexpr double MAX_SPIN_MARGIN = 0.004;
+
+	uint64_t to_ticks(double seconds) const { return static_cast<uint64_t>(seconds * static_cast<double>(m_frequency)); }
+	double to_seconds(int64_t ticks) const { return static_cast<double>(ticks) / static_cast<double>(m_frequency); }
+
+	/* sleeps in slices and measures how far each slice overshoots, the spin margin follows the worst recent overshoot */
+	void sleep_until(uint64_t deadline) {
+		if (m_stats.spin_margin == 0.0) m_stats.spin_margin = MAX_SPIN_MARGIN / 2;
+		for (;;) {
+			uint64_t now = time_raw();
+			double remaining = to_seconds(static_cast<int64_t>(deadline - now)) - m_stats.spin_margin;
+			if (remaining <= 0.0) return;
+
+			double slice = std::min(remaining, 0.001);
+			std::this_thread::sleep_for(std::chrono::duration<double>(slice));
+			double oversleep = to_seconds(static_cast<int64_t>(time_raw() - now)) - slice;
+			double target = std::clamp(oversleep * 1.5, MIN_SPIN_MARGIN, MAX_SPIN_MARGIN);
+			//raise quickly, decay slowly
+			m_stats.spin_margin = target > m_stats.spin_margin ? target : m_stats.spin_margin * 0.99 + target * 0.01;
+		}
+	}
+
+	uint64_t m_frequency;
+	uint64_t m_budget = 0;
+	uint64_t m_deadline = 0;
+	uint64_t m_vsyncPeriod = 0;
+	frame_pacing_stats m_stats;
+};
+
 namespace errors {
 
 template<class ErrorCallback>
 inline void set_callback(ErrorCallback&& callback) {
 	static_assert(std::is_invocable_v<ErrorCallback, error>);
-	detail::glfw_callbacks::error_callback = std::forward<ErrorCallback>(callback);
-	glfwSetErrorCallback(&detail::glfw_callbacks::glfw_error_callback);
+	detail::callbacks::error_callback = std::forward<ErrorCallback>(callback);
+	glfwSetErrorCallback(&detail::callbacks::glfw_error_callback);
 }
 
 inline void set_callback(std::nullptr_t) {
-	detail::glfw_callbacks::error_callback = nullptr;
+	detail::callbacks::error_callback = nullptr;
 	glfwSetErrorCallback(nullptr);
 }
 
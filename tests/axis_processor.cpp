@@ -0,0 +1,52 @@
+/* axis_processor calibration, pure math on a gamepad_snapshot, needs no GLFW init */
+#include "GLFW.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+int failures = 0;
+
+void expect_near(char const* what, float actual, float expected) {
+	if (std::abs(actual - expected) <= 1e-4f) return;
+	std::fprintf(stderr, "%s: expected %f, got %f\n", what, expected, actual);
+	++failures;
+}
+
+void set_axis(glfw::gamepad_snapshot& snapshot, glfw::joystick_id joystick, glfw::gamepad_axis axis, float value) {
+	snapshot.axes[static_cast<size_t>(axis)][glfw::gamepad_snapshot::pad(joystick)] = value;
+}
+
+}
+
+int main() {
+	using glfw::gamepad_axis;
+	constexpr auto pad = glfw::joystick_id::ID1;
+
+	glfw::gamepad_snapshot snapshot;
+	//sticks resting off center, triggers released
+	set_axis(snapshot, pad, gamepad_axis::LeftX, 0.05f);
+	set_axis(snapshot, pad, gamepad_axis::LeftY, -0.05f);
+	set_axis(snapshot, pad, gamepad_axis::LeftTrigger, -1.0f);
+	set_axis(snapshot, pad, gamepad_axis::RightTrigger, -1.0f);
+
+	glfw::axis_processor processor;
+	processor.sticks.inner = 0.0f;
+	processor.triggers.inner = 0.0f;
+	processor.calibrate_center(snapshot, pad);
+	processor.process(snapshot);
+	expect_near("calibrated left x at rest", processor.axis(pad, gamepad_axis::LeftX), 0.0f);
+	expect_near("calibrated left y at rest", processor.axis(pad, gamepad_axis::LeftY), 0.0f);
+	expect_near("released left trigger", processor.axis(pad, gamepad_axis::LeftTrigger), 0.0f);
+	expect_near("released right trigger", processor.axis(pad, gamepad_axis::RightTrigger), 0.0f);
+
+	set_axis(snapshot, pad, gamepad_axis::LeftTrigger, 0.0f);
+	set_axis(snapshot, pad, gamepad_axis::RightTrigger, 1.0f);
+	processor.process(snapshot);
+	expect_near("half pressed left trigger", processor.axis(pad, gamepad_axis::LeftTrigger), 0.5f);
+	expect_near("fully pressed right trigger", processor.axis(pad, gamepad_axis::RightTrigger), 1.0f);
+
+	if (failures == 0) std::puts("axis_processor: ok");
+	return failures == 0 ? 0 : 1;
+}